@@ -0,0 +1,252 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Benchmark of the SERCA MCMC engines (make bench; ./bench).
+//
+// Every number is measured with the Inesi (1988) reference rates and fixed seeds, so runs can be compared
+// across commits and machines. Three levels are timed for each engine variant:
+//
+//   kernel       : one transition table (mid-curve Ca_cyt_conc), kernel_Molecules molecules marched over
+//                  kernel_Steps time steps -> ns per update_States step and molecule-steps per second.
+//                  The fused sweep counts every pCa copy of a molecule; Gillespie counts the dt-steps of
+//                  simulated time it covers (it does not take time steps).
+//   get_Residual : wall time of one call with the production time axis (max_tsteps, dt, steady-state
+//                  window) and --molecules molecules per pCa point, against exp_Calcium.dat.
+//   PSO iteration: wall time of evaluating --particles particles at fixed positions inside the PSO bounds
+//                  on one thread (the position / velocity update itself is negligible).
+//
+// usage: ./bench [--molecules N] [--particles P] [--repeat R] [--seed S] [--ca-data FILE] [--skip-pso]
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include "rng_Philox.h"
+#include "get_Residual.h"
+#include "gillespie_Engine.h"
+#include "population_Engine.h"
+
+using namespace std;
+
+const int kernel_Molecules = 4096;  // molecules of the kernel benchmark
+const int kernel_Steps     = 20000; // time steps of the kernel benchmark
+
+const int n_pCa = 16, max_tsteps = 100001;
+
+struct bench_Variant
+{
+    const char *name;
+    sim_Engine  engine;
+    simd_Level  simd;
+    bool        fused;
+};
+
+const bench_Variant variants[] = {
+    { "fixed-dt scalar", ENGINE_FIXED_DT,  SIMD_SCALAR, false },
+    { "fixed-dt avx2",   ENGINE_FIXED_DT,  SIMD_AVX2,   false },
+    { "fixed-dt avx512", ENGINE_FIXED_DT,  SIMD_AVX512, false },
+    { "fixed-dt fused",  ENGINE_FIXED_DT,  SIMD_AUTO,   true  },
+    { "gillespie",       ENGINE_GILLESPIE, SIMD_AUTO,   false },
+    { "cme",             ENGINE_CME,       SIMD_AUTO,   false },
+    { "cme-ss",          ENGINE_CME_SS,    SIMD_AUTO,   false },
+    { "population",      ENGINE_POPULATION, SIMD_AUTO,  false },
+};
+const int n_Variants = sizeof(variants) / sizeof(variants[0]);
+
+static double seconds_Since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// an explicitly requested SIMD level the CPU lacks is not benchmarked (it would silently run narrower)
+static bool variant_Supported(const bench_Variant &v)
+{
+    return v.simd == SIMD_AUTO || resolve_Simd_Level(v.simd) == v.simd;
+}
+
+//------------------------------------------------------------------
+// kernel: seconds for kernel_Molecules x kernel_Steps molecule-steps (x n_pCa for the fused sweep)
+//------------------------------------------------------------------
+static double time_Kernel(const bench_Variant &v, const serca_Model &model, unsigned long long seed, double &molecule_steps)
+{
+    const float dt = model.dt;
+    transition_Table tables[16];
+    for (int c = 0; c < n_pCa; c++) // Ca_cyt_conc spread like the experimental curve, 1.1e-7 ... 2e-6 M
+    {
+        build_Transition_Table(tables[c], model, 1.1e-7f * powf(10.0f, c / 12.0f));
+    }
+    const transition_Table &table = tables[n_pCa / 2];
+    static uint8_t states[16 * kernel_Molecules];
+    for (int j = 0; j < 16 * kernel_Molecules; j++) states[j] = 0;
+    molecule_steps = (double)kernel_Molecules * kernel_Steps;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    if (v.engine == ENGINE_GILLESPIE)
+    {
+        ss_Accumulator acc;
+        ss_Clear(acc);
+        gillespie_Accumulate(table, dt, seed, 0, n_pCa / 2, 0, kernel_Molecules, 0.0, kernel_Steps * (double)dt, acc);
+    }
+    else if (v.engine == ENGINE_POPULATION)
+    {
+        ss_Window end = { kernel_Steps - 1, kernel_Steps, 1, false, 0, 0.0f, 0.0f }; // one jump to the last step
+        ss_Accumulator acc;
+        ss_Clear(acc);
+        population_Accumulate(table, seed, 0, n_pCa / 2, 0, kernel_Molecules, end, acc);
+    }
+    else if (v.fused)
+    {
+        advance_States_Fused(v.simd, tables, n_pCa, seed, 0, states, kernel_Molecules, 0, kernel_Molecules, 0, kernel_Steps);
+        molecule_steps *= n_pCa;
+    }
+    else
+    {
+        advance_States(v.simd, table, seed, 0, n_pCa / 2, states, 0, kernel_Molecules, 0, kernel_Steps);
+    }
+    return seconds_Since(start);
+}
+
+//------------------------------------------------------------------
+// one get_Residual call; its progress line goes to a sink
+//------------------------------------------------------------------
+static double time_Residual(const bench_Variant &v, const serca_Model &model, const exp_Data &data, int n_molecules,
+                            unsigned long long seed, unsigned int stream_id, float &residual)
+{
+    sim_Config config;
+    config.n_molecules = n_molecules;
+    config.max_tsteps  = max_tsteps;
+    config.window      = make_Window(max_tsteps, 10000, 1000);
+    config.engine      = v.engine;
+    config.simd        = v.simd;
+    config.fused_pCa   = v.fused;
+    config.verbose     = true;
+    adaptive_Config adaptive = { false, 500, 4, 3.0f, 0.0f };
+    int molecules_used;
+    ostringstream sink;
+    streambuf *console = cout.rdbuf(sink.rdbuf());
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    residual = get_Residual(model, config, data, seed, stream_id, adaptive, HUGE_VALF, molecules_used);
+    double seconds = seconds_Since(start);
+    cout.rdbuf(console);
+    return seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    int n_molecules = 1000;
+    int n_particles = 4;
+    int n_repeat    = 3;
+    unsigned long long seed = 20180401ULL;
+    bool skip_pso = false;
+    string ca_data_file = "exp_Calcium.dat";
+    for (int a = 1; a < argc; a++)
+    {
+        if      (string(argv[a]) == "--molecules" && a+1 < argc) n_molecules = atoi(argv[++a]);
+        else if (string(argv[a]) == "--particles" && a+1 < argc) n_particles = atoi(argv[++a]);
+        else if (string(argv[a]) == "--repeat"    && a+1 < argc) n_repeat    = atoi(argv[++a]);
+        else if (string(argv[a]) == "--seed"      && a+1 < argc) seed        = strtoull(argv[++a], NULL, 10);
+        else if (string(argv[a]) == "--ca-data"   && a+1 < argc) ca_data_file = argv[++a];
+        else if (string(argv[a]) == "--skip-pso")                skip_pso    = true;
+    }
+    if (n_repeat < 1) n_repeat = 1;
+    const serca_Model model = inesi_Model();
+    static exp_Data data; // the experimental pCa curve, as main fits it
+    string error;
+    exp_Clear(data);
+    if (!load_Dataset(data, ca_data_file.c_str(), DATA_CALCIUM, 1.0f, 0.0f, error))
+    {
+        cout << " " << error << endl;
+        return 1;
+    }
+
+    cout << " SERCA MCMC benchmark : seed " << seed << ", best SIMD level " << simd_Level_Name(resolve_Simd_Level(SIMD_AUTO))
+         << ", best of " << n_repeat << " repeats" << endl;
+
+    //-------------------------------
+    // kernel
+    //-------------------------------
+    cout << endl << " kernel (" << kernel_Molecules << " molecules x " << kernel_Steps << " steps)" << endl;
+    cout << "   " << left << setw(18) << "variant" << right << setw(14) << "ns / step" << setw(20) << "molecule-steps / s" << endl;
+    for (int i = 0; i < n_Variants; i++)
+    {
+        const bench_Variant &v = variants[i];
+        if (v.engine == ENGINE_CME || v.engine == ENGINE_CME_SS) continue; // no molecules to step
+        cout << "   " << left << setw(18) << v.name << right;
+        if (!variant_Supported(v)) { cout << setw(14) << "n/a" << endl; continue; }
+        double best = HUGE_VAL, molecule_steps = 0;
+        for (int r = 0; r < n_repeat; r++)
+        {
+            double t = time_Kernel(v, model, seed, molecule_steps);
+            if (t < best) best = t;
+        }
+        cout << fixed << setprecision(3) << setw(14) << best / molecule_steps * 1e9
+             << scientific << setprecision(3) << setw(20) << molecule_steps / best << endl;
+    }
+
+    //-------------------------------
+    // get_Residual
+    //-------------------------------
+    cout << endl << " get_Residual (" << n_molecules << " molecules per pCa point, reference rates)" << endl;
+    cout << "   " << left << setw(18) << "variant" << right << setw(14) << "s / call" << setw(14) << "residual" << endl;
+    for (int i = 0; i < n_Variants; i++)
+    {
+        const bench_Variant &v = variants[i];
+        cout << "   " << left << setw(18) << v.name << right;
+        if (!variant_Supported(v)) { cout << setw(14) << "n/a" << endl; continue; }
+        double best = HUGE_VAL;
+        float residual = 0;
+        for (int r = 0; r < n_repeat; r++)
+        {
+            double t = time_Residual(v, model, data, n_molecules, seed, 0, residual);
+            if (t < best) best = t;
+        }
+        cout << fixed << setprecision(4) << setw(14) << best << setprecision(6) << setw(14) << residual << endl;
+    }
+
+    //-------------------------------
+    // PSO iteration
+    //-------------------------------
+    if (skip_pso) return 0;
+    cout << endl << " PSO iteration (" << n_particles << " particles, " << n_molecules << " molecules per pCa point)" << endl;
+    cout << "   " << left << setw(18) << "variant" << right << setw(16) << "s / iteration" << setw(16) << "best residual" << endl;
+    // fixed particle positions: factor 0.1 ... 10 of the reference value, log-uniform from a Philox stream
+    if (n_particles > 64) n_particles = 64;
+    serca_Model particles[64];
+    const int fitted[4] = { K_S0_S1, K_S2_S3, K_S7_S8, K_S9_S10 };
+    philox_Stream rng;
+    rng_Init(rng, seed, 0, 0, 0);
+    for (int i = 0; i < n_particles; i++) particles[i] = model;
+    for (int k = 0; k < 4; k++)
+    {
+        for (int i = 0; i < n_particles; i++) particles[i].rates[fitted[k]] *= powf(10.0f, 2.0f * rng_Uniform(rng) - 1.0f);
+    }
+    for (int i = 0; i < n_Variants; i++)
+    {
+        const bench_Variant &v = variants[i];
+        cout << "   " << left << setw(18) << v.name << right;
+        if (!variant_Supported(v)) { cout << setw(14) << "n/a" << endl; continue; }
+        double best = HUGE_VAL;
+        float best_residual = HUGE_VALF;
+        for (int r = 0; r < n_repeat; r++)
+        {
+            double t = 0;
+            for (int j = 0; j < n_particles; j++)
+            {
+                float residual;
+                t += time_Residual(v, particles[j], data, n_molecules, seed, j, residual);
+                if (residual < best_residual) best_residual = residual;
+            }
+            if (t < best) best = t;
+        }
+        cout << fixed << setprecision(4) << setw(16) << best << setprecision(6) << setw(16) << best_residual << endl;
+    }
+    return 0;
+}
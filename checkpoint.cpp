@@ -0,0 +1,93 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Atomic binary checkpoint files (see checkpoint.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+using namespace std;
+
+static const char     checkpoint_Magic[8] = { 'S', 'E', 'R', 'C', 'A', 'P', 'S', 'O' };
+static const uint32_t checkpoint_Version  = 2;
+
+struct checkpoint_Header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t size;     // payload bytes
+    uint64_t checksum; // FNV-1a of the payload
+};
+
+static uint64_t fnv1a(const void *data, size_t size)
+{
+    const unsigned char *byte = (const unsigned char *)data;
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ byte[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool write_Checkpoint(const char *file, const void *state, size_t size)
+{
+    checkpoint_Header header;
+    memcpy(header.magic, checkpoint_Magic, sizeof(header.magic));
+    header.version  = checkpoint_Version;
+    header.reserved = 0;
+    header.size     = size;
+    header.checksum = fnv1a(state, size);
+
+    string tmp = string(file) + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "wb");
+    if (out == NULL) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(state, size, 1, out) == 1;
+    ok = (fflush(out) == 0) && ok;
+    ok = (fsync(fileno(out)) == 0) && ok;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), file) != 0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool read_Checkpoint(const char *file, void *state, size_t size, string &error)
+{
+    FILE *in = fopen(file, "rb");
+    if (in == NULL)
+    {
+        error = string("cannot open ") + file;
+        return false;
+    }
+    checkpoint_Header header;
+    bool ok = fread(&header, sizeof(header), 1, in) == 1;
+    if (!ok || memcmp(header.magic, checkpoint_Magic, sizeof(header.magic)) != 0)
+    {
+        error = string(file) + " is not a swarm checkpoint";
+        ok = false;
+    }
+    else if (header.version != checkpoint_Version || header.size != size)
+    {
+        error = string(file) + " was written by another version of the program";
+        ok = false;
+    }
+    else if (fread(state, size, 1, in) != 1 || fnv1a(state, size) != header.checksum)
+    {
+        error = string(file) + " is truncated or corrupt";
+        ok = false;
+    }
+    fclose(in);
+    return ok;
+}
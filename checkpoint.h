@@ -0,0 +1,21 @@
+/*-----------------------------------------------------------------------------------------------------
+// Binary checkpoints of the PSO swarm (--checkpoint FILE, --resume FILE).
+//
+// A checkpoint is one plain struct (main.cpp collects the swarm into it), framed by a header (magic,
+// version, size) and an FNV-1a checksum of the payload. write_Checkpoint writes FILE.tmp, flushes it to
+// disk and renames it over FILE, so a job killed mid-write leaves the previous checkpoint intact.
+// The files are meant for restarting on the same build and machine: the payload is raw bytes.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <string>
+
+bool write_Checkpoint(const char *file, const void *state, size_t size);
+
+// false with a message in error if file is missing, truncated, of another size/version or corrupt
+bool read_Checkpoint (const char *file, void *state, size_t size, std::string &error);
+
+#endif
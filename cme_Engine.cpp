@@ -0,0 +1,212 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Master-equation solutions of the SERCA scheme (see cme_Engine.h).
+//
+// Steady state : pi Q = 0 with sum(pi) = 1. Transposed, Q^T pi = 0; one of its equations is redundant
+//                (the columns of Q^T sum to zero), so the last one is replaced by the normalisation row.
+//
+// Window mean  : P(t) = P(0) exp(Q t), so
+//                    mean over [t1, t2) = P(0) exp(Q t1) * (1/tau) int_0^tau exp(Q s) ds ,  tau = t2 - t1
+//                The integral is the top-right block of exp([[Q tau, I], [0, 0]]). Both exponentials use
+//                scaling and squaring with a Taylor series.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+#include "cme_Engine.h"
+
+const int max_Dim = 2 * n_States; // largest matrix exponentiated (the augmented window matrix)
+
+//------------------------------------------------------------------
+// generator from the per-step branch probabilities
+//------------------------------------------------------------------
+static void build_Generator(const transition_Table &table, float dt, double Q[n_States][n_States])
+{
+    memset(Q, 0, sizeof(double) * n_States * n_States);
+    for (int s = 0; s < n_States; s++)
+    {
+        double prob[max_Branch + 1];
+        branch_Probabilities(table, s, prob);
+        for (int k = 0; k < max_Branch; k++)
+        {
+            double rate = prob[k] / dt;
+            Q[s][table.next[s][k]] += rate;
+            Q[s][s]                -= rate;
+        }
+    }
+}
+
+static void mat_Mul(int n, const double A[max_Dim][max_Dim], const double B[max_Dim][max_Dim], double C[max_Dim][max_Dim])
+{
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            double sum = 0.0;
+            for (int k = 0; k < n; k++)
+            {
+                sum += A[i][k] * B[k][j];
+            }
+            C[i][j] = sum;
+        }
+    }
+}
+
+//------------------------------------------------------------------
+// E = exp(A) for an n x n matrix (A is overwritten)
+//------------------------------------------------------------------
+static void mat_Exp(int n, double A[max_Dim][max_Dim], double E[max_Dim][max_Dim])
+{
+    double norm = 0.0; // infinity norm
+    for (int i = 0; i < n; i++)
+    {
+        double row = 0.0;
+        for (int j = 0; j < n; j++) row += fabs(A[i][j]);
+        if (row > norm) norm = row;
+    }
+    int squarings = 0;
+    while (norm > 0.5) { norm *= 0.5; squarings++; }
+    double scale = ldexp(1.0, -squarings);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++) A[i][j] *= scale;
+
+    // Taylor series, ||A|| <= 1/2 so 18 terms are far below double precision
+    double term[max_Dim][max_Dim], next[max_Dim][max_Dim];
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            term[i][j] = E[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+    for (int k = 1; k <= 18; k++)
+    {
+        mat_Mul(n, term, A, next);
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                term[i][j] = next[i][j] / k;
+                E[i][j]   += term[i][j];
+            }
+        }
+    }
+    for (int q = 0; q < squarings; q++)
+    {
+        mat_Mul(n, E, E, next);
+        memcpy(E, next, sizeof(next));
+    }
+}
+
+//--------------------------------------------------------------------------//
+
+void cme_Steady_State(const transition_Table &table, float dt, float occupancy[n_States])
+{
+    double Q[n_States][n_States];
+    build_Generator(table, dt, Q);
+
+    double A[n_States][n_States]; // A = Q^T, normalisation in the last row
+    double b[n_States] = {0};
+    for (int i = 0; i < n_States; i++)
+        for (int j = 0; j < n_States; j++) A[i][j] = Q[j][i];
+    for (int s = 0; s < n_States; s++)
+    {
+        A[n_States - 1][s] = 1.0;
+    }
+    b[n_States - 1] = 1.0;
+
+    //------------------------------------------------------------------
+    // Gaussian elimination with partial pivoting
+    //------------------------------------------------------------------
+    for (int c = 0; c < n_States; c++)
+    {
+        int pivot = c;
+        for (int r = c + 1; r < n_States; r++)
+        {
+            if (fabs(A[r][c]) > fabs(A[pivot][c])) pivot = r;
+        }
+        if (pivot != c)
+        {
+            for (int k = 0; k < n_States; k++)
+            {
+                double tmp = A[c][k]; A[c][k] = A[pivot][k]; A[pivot][k] = tmp;
+            }
+            double tmp = b[c]; b[c] = b[pivot]; b[pivot] = tmp;
+        }
+        if (A[c][c] == 0.0) continue; // state c unreachable: its occupancy stays 0
+        for (int r = c + 1; r < n_States; r++)
+        {
+            double f = A[r][c] / A[c][c];
+            if (f == 0.0) continue;
+            for (int k = c; k < n_States; k++)
+            {
+                A[r][k] -= f * A[c][k];
+            }
+            b[r] -= f * b[c];
+        }
+    }
+
+    //------------------------------------------------------------------
+    // back substitution
+    //------------------------------------------------------------------
+    double pi[n_States];
+    for (int r = n_States - 1; r >= 0; r--)
+    {
+        double sum = b[r];
+        for (int k = r + 1; k < n_States; k++)
+        {
+            sum -= A[r][k] * pi[k];
+        }
+        pi[r] = (A[r][r] != 0.0) ? sum / A[r][r] : 0.0;
+    }
+    for (int s = 0; s < n_States; s++)
+    {
+        occupancy[s] = (float)pi[s];
+    }
+}
+
+void cme_Window_Average(const transition_Table &table, float dt, double t_begin, double t_end,
+                        float occupancy[n_States])
+{
+    double Q[n_States][n_States];
+    build_Generator(table, dt, Q);
+    double tau = t_end - t_begin;
+
+    //------------------------------------------------------------------
+    // P(t_begin) = S0 row of exp(Q t_begin)
+    //------------------------------------------------------------------
+    double A[max_Dim][max_Dim], E[max_Dim][max_Dim];
+    for (int i = 0; i < n_States; i++)
+        for (int j = 0; j < n_States; j++) A[i][j] = Q[i][j] * t_begin;
+    mat_Exp(n_States, A, E);
+    double P_begin[n_States];
+    for (int j = 0; j < n_States; j++)
+    {
+        P_begin[j] = E[0][j];
+    }
+
+    //------------------------------------------------------------------
+    // (1/tau) int_0^tau exp(Q s) ds from the augmented matrix [[Q tau, I], [0, 0]]
+    //------------------------------------------------------------------
+    memset(A, 0, sizeof(A));
+    for (int i = 0; i < n_States; i++)
+    {
+        for (int j = 0; j < n_States; j++) A[i][j] = Q[i][j] * tau;
+        A[i][n_States + i] = 1.0;
+    }
+    mat_Exp(max_Dim, A, E);
+    for (int j = 0; j < n_States; j++)
+    {
+        double sum = 0.0;
+        for (int i = 0; i < n_States; i++)
+        {
+            sum += P_begin[i] * E[i][n_States + j];
+        }
+        occupancy[j] = (float)sum;
+    }
+}
@@ -0,0 +1,26 @@
+/*-----------------------------------------------------------------------------------------------------
+// Deterministic occupancy of the SERCA scheme from the chemical master equation.
+//
+// For independent molecules the master equation of the 13-state chain is linear, dP/dt = P Q, with the
+// generator Q[s][to] = rate of s -> to and Q[s][s] = -(sum of the rates out of s). Q is taken from the same
+// transition_Table as the Monte Carlo engines (branch probability per step / dt), so it is the same scheme.
+//
+//  cme_Steady_State   : t -> infinity. The normalised left null vector of Q, one 13 x 13 dense LU solve.
+//                       (The fixed-dt chain has the transition matrix I + Q dt, so this is also its
+//                       stationary distribution.)
+//  cme_Window_Average : P(0) = S0, averaged over the steady-state window [t_begin, t_end) -- the quantity
+//                       the stochastic engines estimate, without the sampling noise. With the default
+//                       10 ms of simulated time the slow steps (S6 -> S7, S8 <-> S9, ...) have not relaxed
+//                       yet, so this differs from cme_Steady_State.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef CME_ENGINE_H
+#define CME_ENGINE_H
+
+#include "update_States.h"
+
+void cme_Steady_State  (const transition_Table &table, float dt, float occupancy[n_States]);
+void cme_Window_Average(const transition_Table &table, float dt, double t_begin, double t_end,
+                        float occupancy[n_States]);
+
+#endif
@@ -0,0 +1,115 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Loader of the experimental curves (see exp_Data.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include "exp_Data.h"
+#include "perf_Counters.h"
+
+using namespace std;
+
+void exp_Clear(exp_Data &data)
+{
+    memset(&data, 0, sizeof(data)); // plain bytes: it is broadcast as such
+}
+
+bool load_Dataset(exp_Data &data, const char *file, data_Kind kind, float weight, float Ca_cyt_conc,
+                  string &error)
+{
+    ifstream in(file);
+    if (!in.is_open())
+    {
+        error = string("cannot open ") + file;
+        return false;
+    }
+    if (data.n_datasets >= max_Datasets)
+    {
+        error = string("too many datasets, ") + file + " not loaded";
+        return false;
+    }
+    exp_Dataset &set = data.set[data.n_datasets];
+    set.kind        = kind;
+    set.first       = data.n_points;
+    set.n_points    = 0;
+    set.weight      = weight;
+    set.Ca_cyt_conc = Ca_cyt_conc;
+    strncpy(set.file, file, sizeof(set.file) - 1);
+    set.file[sizeof(set.file) - 1] = '\0';
+
+    string line;
+    int    line_no = 0;
+    while (getline(in, line))
+    {
+        line_no++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == string::npos || line[start] == '#') continue; // blank or comment
+
+        // strtod, then float: the same rounding as the float literals the curves used to be
+        const char *text = line.c_str() + start;
+        char *end_conc, *end_bound;
+        double conc  = strtod(text, &end_conc);
+        double bound = strtod(end_conc, &end_bound);
+        if (end_conc == text || end_bound == end_conc || end_bound[strspn(end_bound, " \t\r")] != '\0')
+        {
+            ostringstream msg;
+            msg << file << ":" << line_no << ": expected \"concentration value\"";
+            error = msg.str();
+            data.n_points = set.first;
+            return false;
+        }
+        if (data.n_points >= max_Data_Points)
+        {
+            error = string("more than the data block holds in ") + file;
+            data.n_points = set.first;
+            return false;
+        }
+        data.conc      [data.n_points] = (float)conc;
+        data.norm_bound[data.n_points] = (float)bound;
+        data.n_points++;
+        set.n_points++;
+    }
+    if (set.n_points == 0)
+    {
+        error = string("no data points in ") + file;
+        data.n_points = set.first;
+        return false;
+    }
+    data.n_datasets++;
+    return true;
+}
+
+const char *data_Kind_Name(data_Kind kind)
+{
+    return (kind == DATA_PHOSPHATE) ? "bound Pi vs Pi" : "bound Ca vs Ca";
+}
+
+void build_Data_Tables(transition_Table tables[], const serca_Model &model, const exp_Data &data)
+{
+    PERF_TIMER(KERNEL_TABLES);
+    for (int d = 0; d < data.n_datasets; d++)
+    {
+        const exp_Dataset &set = data.set[d];
+        for (int c = set.first; c < set.first + set.n_points; c++)
+        {
+            if (set.kind == DATA_PHOSPHATE)
+            {
+                serca_Model at_Pi = model;
+                at_Pi.Pi_conc     = data.conc[c];
+                build_Transition_Table(tables[c], at_Pi, set.Ca_cyt_conc);
+            }
+            else
+            {
+                build_Transition_Table(tables[c], model, data.conc[c]);
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+/*-----------------------------------------------------------------------------------------------------
+// The experimental curves the residual is fitted against (exp_Calcium.dat, exp_Phosphate.dat, ...).
+//
+// A data file has "#" comment lines and one "concentration normalised_observable" pair per line. All
+// loaded curves share one contiguous block (conc[], norm_bound[]): a dataset is a slice of it plus what
+// is varied along the curve and the weight of its residual. The block is plain data, read once at startup
+// (rank 0, then broadcast as bytes) and only passed around as const exp_Data & afterwards, so the
+// threads and ranks share it and nothing is re-created per get_Residual call.
+//
+// Point c of the block (over all datasets) is simulated with random streams (stream_id, c, rr), so the
+// first dataset keeps the streams the single pCa curve always had.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef EXP_DATA_H
+#define EXP_DATA_H
+
+#include <string>
+#include "update_States.h"
+
+const int max_Datasets    = 4;
+const int max_Data_Points = 64; // all datasets together
+
+enum data_Kind
+{
+    DATA_CALCIUM = 0, // Ca_cyt_conc varied,              observable: bound Ca
+    DATA_PHOSPHATE    // Pi_conc varied at a fixed Ca_cyt, observable: bound phosphate (S5 ... S11)
+};
+
+struct exp_Dataset
+{
+    data_Kind kind;
+    int       first;       // first point of the curve in the block
+    int       n_points;
+    float     weight;      // the residual is the weighted sum of the curve residuals
+    float     Ca_cyt_conc; // DATA_PHOSPHATE: cytosolic Ca at which Pi is varied (M)
+    char      file[128];
+};
+
+struct exp_Data
+{
+    int         n_datasets;
+    int         n_points;                    // all datasets together
+    exp_Dataset set[max_Datasets];
+    float       conc      [max_Data_Points]; // the varied concentration (M)
+    float       norm_bound[max_Data_Points]; // the experimental observable, normalised to its maximum
+};
+
+void exp_Clear(exp_Data &data);
+
+// appends the curve in file to data; false with a message in error if the file cannot be read,
+// a line is malformed or the block is full
+bool load_Dataset(exp_Data &data, const char *file, data_Kind kind, float weight, float Ca_cyt_conc,
+                  std::string &error);
+
+const char *data_Kind_Name(data_Kind kind);
+
+// tables[c] for every point c of the block: the model at the point's concentrations
+void build_Data_Tables(transition_Table tables[], const serca_Model &model, const exp_Data &data);
+
+#endif
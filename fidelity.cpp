@@ -0,0 +1,85 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Fidelity schedule of the swarm iterations (see fidelity.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <sstream>
+#include <stdlib.h>
+#include <ctype.h>
+#include "fidelity.h"
+
+using namespace std;
+
+bool parse_Fidelity(fidelity_Schedule &schedule, const char *spec, const fidelity_Level &full, string &error)
+{
+    schedule.n_levels = 0;
+    stringstream in(spec);
+    string token;
+    while (getline(in, token, ','))
+    {
+        fidelity_Level level = full;
+        string name  = token;
+        string count;
+        size_t colon = token.find(':');
+        if (colon != string::npos)
+        {
+            name  = token.substr(0, colon);
+            count = token.substr(colon + 1);
+        }
+        else if (!token.empty() && isdigit((unsigned char)token[0]))
+        {
+            name.clear();
+            count = token;
+        }
+        if (!name.empty())
+        {
+            if (!parse_Sim_Engine(name.c_str(), level.engine))
+            {
+                error = "unknown engine " + name + " in --fidelity " + spec;
+                return false;
+            }
+        }
+        if (!count.empty())
+        {
+            level.n_molecules = atoi(count.c_str());
+            if (level.n_molecules <= 0 || level.n_molecules > full.n_molecules)
+            {
+                error = "molecule count " + count + " in --fidelity " + spec + " is not in 1 ... n_SERCA_Molecules";
+                return false;
+            }
+        }
+        if (schedule.n_levels == max_Fidelity_Levels - 1)
+        {
+            error = string("too many levels in --fidelity ") + spec;
+            return false;
+        }
+        schedule.level[schedule.n_levels++] = level;
+    }
+    const fidelity_Level &last = schedule.level[schedule.n_levels > 0 ? schedule.n_levels - 1 : 0];
+    if (schedule.n_levels == 0 || last.engine != full.engine || last.n_molecules != full.n_molecules)
+    {
+        schedule.level[schedule.n_levels++] = full;
+    }
+    return true;
+}
+
+int fidelity_Index(const fidelity_Schedule &schedule, float progress)
+{
+    if (schedule.n_levels <= 1) return 0;
+    int index = (int)(progress * schedule.n_levels);
+    if (index < 0) index = 0;
+    if (index > schedule.n_levels - 1) index = schedule.n_levels - 1;
+    return index;
+}
+
+string fidelity_Name(const fidelity_Level &level)
+{
+    stringstream name;
+    name << sim_Engine_Name(level.engine) << " x " << level.n_molecules;
+    return name.str();
+}
@@ -0,0 +1,44 @@
+/*-----------------------------------------------------------------------------------------------------
+// Progressive fidelity of the swarm iterations (--fidelity LEVELS).
+//
+// Early swarm iterations only need a rough ranking of the particles, so they can be evaluated with
+// fewer molecules or with the master equation. A schedule is a list of levels from cheap to full,
+// e.g. "cme,1000,3000": the CME engine, then 1000 and 3000 molecules with the --engine of the run;
+// the full level (--engine, n_SERCA_Molecules) is appended if the list does not end with it. The swarm
+// moves up one level each time the inertia weight has covered another 1/n_levels of its range
+// (w_min ... w_max), so the last part of the run is evaluated at full fidelity. Residuals of different
+// levels are not comparable: when the level changes, main re-evaluates all pbest positions at the new
+// level and gbest becomes the best of them.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef FIDELITY_H
+#define FIDELITY_H
+
+#include <string>
+#include "sim_Engine.h"
+
+const int max_Fidelity_Levels = 8;
+
+struct fidelity_Level
+{
+    sim_Engine engine;
+    int        n_molecules; // per data point
+};
+
+struct fidelity_Schedule
+{
+    int            n_levels; // 0: always full fidelity
+    fidelity_Level level[max_Fidelity_Levels];
+};
+
+// comma-separated levels: a molecule count (with full.engine), an engine name (with full.n_molecules)
+// or ENGINE:COUNT, e.g. "cme,1000,gillespie:3000"; full is appended unless it is the last level
+bool parse_Fidelity(fidelity_Schedule &schedule, const char *spec, const fidelity_Level &full, std::string &error);
+
+// the level at progress = (w - w_min) / (w_max - w_min) of the inertia weight, 0 ... 1
+int fidelity_Index(const fidelity_Schedule &schedule, float progress);
+
+// e.g. "cme x 10000"
+std::string fidelity_Name(const fidelity_Level &level);
+
+#endif
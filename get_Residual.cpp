@@ -48,397 +48,272 @@
 #include <stdlib.h>
 #include <iomanip>
 #include <time.h>
+#include "update_States.h"
+#include "steady_State.h"
 #include "get_Residual.h"
-
-//const int   max_tsteps              = 1000001;
-const int save_jump = 1000; //how many output values should we keep? To minimize memory usage, we will keep every 10 timepoints.
+#include "sim_Workspace.h"
+#include "gpu_Engine.h"
+#include "perf_Counters.h"
 
 using namespace std;
-float Ca_cyt_conc;
 
-float count_S0, count_S1, count_S2, count_S3, count_S4, count_S5, count_S6a, count_S7, count_S6, count_S8, count_S9, count_S10, count_S11;
-float S0_SS, S1_SS, S2_SS, S3_SS, S4_SS, S5_SS, S6a_SS, S7_SS, S6_SS, S8_SS, S9_SS, S10_SS, S11_SS;
-float S0_temp, S1_temp, S2_temp, S3_temp, S4_temp, S5_temp, S6a_temp, S7_temp, S6_temp, S8_temp, S9_temp, S10_temp, S11_temp;
-int state;
-bool open_closed; //O is open 1 is closed
-float residual;
+//--------------------------------------------------------------------------//
+
+// Ca bound per SERCA: S1 + S2 + S9 + S8 + 2 * (S3 + S4 + S5 + S6a + S7 + S6)
+static float bound_Ca(const float SS[n_States])
+{
+    return SS[1] + SS[2] + SS[10] + SS[9] + 2* (SS[3] + SS[4] + SS[5] + SS[6] + SS[7] + SS[8]);
+}
 
-//functions to be called
-void update_States(int &state, float &dt,
-                   float &k_S0_S1, float &k_S0_S11,
-                   float &Ca_cyt_conc, float &Ca_sr_conc,
-                   float &Pi_conc, float &MgATP_conc, float &MgADP_conc,
-                   float &k_S1_S2, float &k_S1_S0,
-                   float &k_S2_S3, float &k_S2_S1,
-                   float &k_S3_S4, float &k_S3_S2,
-                   float &k_S4_S5, float &k_S4_S3,
-                   float &k_S5_S6a, float &k_S5_S4,
-                   float &k_S5_S6, float &k_S6_S5,
-                   float &k_S6a_S7, float &k_S6a_S5,
-                   float &k_S7_S8, float &k_S7_S6a,
-                   float &k_S7_S6, float &k_S6_S7,
-                   float &k_S8_S9, float &k_S8_S7,
-                   float &k_S9_S10, float &k_S9_S8,
-                   float &k_S10_S11, float &k_S10_S9,
-                   float &k_S11_S0, float &k_S11_S10
-                   );
+// phosphate bound per SERCA (phosphoenzyme and *E-Pi): S5 + S6a + S7 + S6 + S8 + S9 + S10 + S11
+static float bound_Pi(const float SS[n_States])
+{
+    return SS[5] + SS[6] + SS[7] + SS[8] + SS[9] + SS[10] + SS[11] + SS[12];
+}
 
+static float observable(data_Kind kind, const float SS[n_States])
+{
+    return (kind == DATA_PHOSPHATE) ? bound_Pi(SS) : bound_Ca(SS);
+}
+
+//------------------------------------------------------------------
+// residual of a bound-Ca curve against the normalised experiment:
+//     sqrt( sum (exp - bound / max(bound))^2 )
+//------------------------------------------------------------------
+static double residual_Of_Curve(const float *bound, const float *norm_exp, int n_pCa)
+{
+    int    i_max = 0;
+    for (int cal = 1; cal < n_pCa; cal++)
+    {
+        if (bound[cal] > bound[i_max]) i_max = cal;
+    }
+    double b_max = bound[i_max];
+    double residual_temp = 0.0;
+    for (int cc = 0; cc < n_pCa; cc++)  // Ca-loop
+    {
+        double diff = norm_exp[cc] - (float)(bound[cc] / b_max);
+        residual_temp = residual_temp + pow (diff,2); // normalized force
+    }
+    return pow(residual_temp,0.5);
+}
 
+// weighted sum of the curve residuals
+static double residual_Of_Data(const exp_Data &data, const float *bound)
+{
+    double residual = 0.0;
+    for (int d = 0; d < data.n_datasets; d++)
+    {
+        const exp_Dataset &set = data.set[d];
+        residual += set.weight * residual_Of_Curve(bound + set.first, data.norm_bound + set.first, set.n_points);
+    }
+    return residual;
+}
 
 //--------------------------------------------------------------------------//
 
-float get_Residual(int    & n_SERCA_Molecules,
-                   int    & max_tsteps,
-                   float  & dt,
-                   int    & n_s,
-                   int    & n_pCa,
-                   float  & k_S0_S1,
-                   float  & k_S2_S3,
-                   float  & k_S7_S8,
-                   float  & k_S9_S10,float  & k_S1_S0, float  & k_S1_S2,  float  & k_S2_S1, float  & k_S3_S2, float  & k_S3_S4,  float  & k_S4_S3, float  & k_S4_S5, float  & k_S5_S4, float  & k_S5_S6a,  float  & k_S6a_S5, float  & k_S6a_S7, float  & k_S7_S6a, float  & k_S5_S6,  float  & k_S6_S5, float  & k_S6_S7, float  & k_S7_S6,  float  & k_S8_S7, float  & k_S8_S9, float  & k_S9_S8,float  & k_S10_S9, float  & k_S10_S11,float  & k_S11_S10,float  & k_S11_S0,float  & k_S0_S11, float  & Ca_sr_conc,float  & MgATP_conc,float  & MgADP_conc,float  & Pi_conc
+float get_Residual(const serca_Model & model, const sim_Config & config, const exp_Data & data,
+                   unsigned long long seed, unsigned int stream_id,
+                   const adaptive_Config & adaptive, float prune_above, int & molecules_used,
+                   residual_State * state
                    )
 
 {
-    float boundSS_max_temp = 0; // this will figure out the highest bound Ca for our loop
-    float calConc[16] = {   1.13465021562703E-07,
-                            1.48013728928924E-07,
-                            1.87545047401295E-07,
-                            2.37746427649773E-07,
-                            2.86177839072689E-07,
-                            3.34581558654772E-07,
-                            3.82579504194903E-07,
-                            4.40880103529033E-07,
-                            5.15498018194447E-07,
-                            6.0268752205741E-07,
-                            7.04360511231999E-07,
-                            8.41433890215616E-07,
-                            9.8310521528177E-07,
-                            1.209326027507E-06,
-                            1.46539261994034E-06,
-                            1.92506766806173E-06};
-    
-    float norm_bound_Ca_Exp[16] = { 0.056698042688369,
-                                    0.100474048769127,
-                                    0.159057553309407,
-                                    0.23871761522272,
-                                    0.30582603399111,
-                                    0.385634231598201,
-                                    0.459159901847406,
-                                    0.551640962566692,
-                                    0.63566454650982,
-                                    0.715472730890509,
-                                    0.778419740266281,
-                                    0.835003303161443,
-                                    0.885304272566714,
-                                    0.935510990636819,
-                                    0.970991050011721,
-                                    1};
+    // all working variables are local or in the thread's workspace, so that several particles can be
+    // solved at once (OpenMP/MPI)
+    const int n_SERCA_Molecules = config.n_molecules;
+    const int n_points          = data.n_points; // all curves, one block (see exp_Data.h)
+    const sim_Engine engine     = config.engine;
+    const float dt              = model.dt;
+    float SS[n_States]; // steady-state occupancy of S0 ... S11 (state indices, see update_States.h)
+    float residual;
 
-    
-    //CHANGED - this was taking up too much memory. Now only saving every 10 timesteps.
-    //float Time[(max_tsteps-1)/10];
-    float S0[(max_tsteps-1)/10];         // used to find how many S0 molecules in each iteration ("E")
-    float S1[(max_tsteps-1)/10];         //  "E.Ca"
-    float S2[(max_tsteps-1)/10];         //  "E'.Ca"
-    float S3[(max_tsteps-1)/10];         //  "E'.Ca2"
-    float S4[(max_tsteps-1)/10];         //  "E'.ATP.Ca2"
-    float S5[(max_tsteps-1)/10];         //  "E'~P.ADP.Ca2"
-    float S6a[(max_tsteps-1)/10];         // "*E'~P.ADP.Ca2"
-    float S7[(max_tsteps-1)/10];         // "*E'-P.Ca2"
-    float S6[(max_tsteps-1)/10];         //  "E'~P.Ca2"
-    float S8[(max_tsteps-1)/10];         // "*E-P.Ca2"
-    float S9[(max_tsteps-1)/10];        // "*E-P.Ca"
-    float S10[(max_tsteps-1)/10];        // "*E-P"
-    float S11[(max_tsteps-1)/10];        // "*E-Pi"
-    
-    
-    
     residual = 0;
-    float ss_bound_Ca[n_pCa];
-    float norm_ss_bound_Ca[n_pCa];
+    molecules_used = 0;
+    if (n_points <= 0 || n_points > max_Data_Points) return residual;
+    PERF_CALL_BEGIN;
+    sim_Workspace &ws = worker_Workspace();
+    float            *ss_bound   = ws.bound;
+    float            *batch_bound = ws.batch_bound;
+    double           residual_mean = 0.0, residual_M2 = 0.0; // running mean / sum of squares of the batch residuals (Welford)
+    transition_Table *table_pCa  = ws.tables;
+    ss_Accumulator   *acc_pCa    = ws.acc;
+    ss_Accumulator   *acc_batch  = ws.acc_batch;
+    data_Kind        *kind       = ws.kind; // observable of each point
     
-    for (int cal = 0; cal < n_pCa; cal++)
+    build_Data_Tables(table_pCa, model, data);
+    for (int d = 0; d < data.n_datasets; d++)
     {
-            Ca_cyt_conc       = calConc[cal];  // needs citation
-        //-----------------------
-        // SIMULATION FOR SS CURVE
-        //-----------------------
-        //Creating a vector named tstapes (list of elements of States S0-S11) defining the occupancy of each state according to time at each time step
-
-        
-        // create a temporary count (initial count of state and set it equal to zero. The count will be calculated and set equal to the variables above for each state. This is because C++ will use the last value that was defined, so its a “clear” or reset function
-        S0_temp = 0;
-        S1_temp = 0;
-        S2_temp = 0;
-        S3_temp = 0;
-        S4_temp = 0;
-        S5_temp = 0;
-        S6a_temp = 0;
-        S7_temp = 0;
-        S6_temp = 0;
-        S8_temp = 0;
-        S9_temp = 0;
-        S10_temp = 0;
-        S11_temp = 0;
-        
-        S0_SS = 0;
-        S1_SS = 0;
-        S2_SS = 0;
-        S3_SS = 0;
-        S4_SS = 0;
-        S5_SS = 0;
-        S6a_SS = 0;
-        S7_SS = 0;
-        S6_SS = 0;
-        S8_SS = 0;
-        S9_SS = 0;
-        S10_SS = 0;
-        S11_SS = 0;
-        
-        
-        //-----------------------------------------------------------------------------------------------------------------//
-        // start repeat loop i.e., using r-index - REPEAT PROCESS FOR EACH SERCA MOLECULE
-        //------------------------------------------------------------------------------------------------------------------//
-        //start in state 0 which is SERCA in open, then go through in time and ##
-        for (int rr = 0; rr < n_SERCA_Molecules; rr++) //repetition of whole simulation to smooth curve
+        for (int cal = data.set[d].first; cal < data.set[d].first + data.set[d].n_points; cal++) kind[cal] = data.set[d].kind;
+    }
+    for (int cal = 0; cal < n_points; cal++)
+    {
+            ss_Clear(acc_pCa[cal]);
+    }
+    
+    //-----------------------
+    // SIMULATION FOR SS CURVE
+    //-----------------------
+    // all molecules in one batch, unless the adaptive mode may stop early (only for the stochastic engines)
+    int batch = n_SERCA_Molecules;
+    if (adaptive.enabled && engine_Is_Stochastic(engine) && adaptive.batch > 0)
+    {
+        batch = adaptive.batch;
+    }
+    int n_batches = 0;
+    int first_molecule = 0;
+    molecules_used = 0;
+    bool pruned = false;
+    if (state != NULL && state->n_molecules > 0 && (int)state->acc.size() == n_points)
+    {
+        // go on from an earlier call: its molecules count, the new ones continue its streams
+        stream_id      = state->stream_id;
+        first_molecule = molecules_used = state->n_molecules;
+        n_batches      = state->n_batches;
+        residual_mean  = state->residual_mean;
+        residual_M2    = state->residual_M2;
+        for (int cal = 0; cal < n_points; cal++) acc_pCa[cal] = state->acc[cal];
+    }
+    for (int first = first_molecule; first < n_SERCA_Molecules; first += batch)
+    {
+        int n_batch = (n_SERCA_Molecules - first < batch) ? n_SERCA_Molecules - first : batch;
+        n_batches++;
+        // fraction of the SERCA molecules in each state, averaged over the steady-state window
+        for (int cal = 0; cal < n_points; cal++) ss_Clear(acc_batch[cal]);
+        engine_Accumulate_Sweep(config, table_pCa, n_points, dt, seed, stream_id, first, n_batch, acc_batch);
+        for (int cal = 0; cal < n_points; cal++)
         {
-            state = 0; // Note: each time we repeat the simulation, we should set all SERCA to state 0 (EiH2)
-            open_closed = 0; // initially, each molecule is in closed conformation (0)
-            //---------------------------------------------------------------------------------------------------------------//
-            // start time loop i.e., using n-index
-            //----------------------------------------------------------------------------------------------------------------//
-            int output_count = 10; //every 10 timepoints, we will save the data (starting with data point 0)
-            for (int n = 0; n < max_tsteps; n++)  // time marching
-            {  // begin n-loop for time marching
-                //
-                //setting counts of all states equal to zero to initialize which will later be used to find how many SERCA in each iteration
-                //
-                count_S0  = 0.0;   // "E"
-                count_S1  = 0.0;  //  "E.Ca"
-                count_S2  = 0.0;  //  "E'.Ca"
-                count_S3  = 0.0;  //  "E'.Ca2"
-                count_S4  = 0.0;  //  "E'.ATP.Ca2"
-                count_S5  = 0.0;  //  "E'~P.ADP.Ca2"
-                count_S6a  = 0.0;  // "*E'~P.ADP.Ca2"
-                count_S7  = 0.0;  // "*E'-P.Ca2"
-                count_S6  = 0.0;  //  "E'~P.Ca2"
-                count_S8  = 0.0;  // "*E-P.Ca2"
-                count_S9 = 0.0;  // "*E-P.Ca"
-                count_S10 = 0.0;  // "*E-P"
-                count_S11 = 0.0;  // "*E-Pi"
-                
-                
-                //count << "open_closed = " << open_closed << endl;
-                
-                //update all RUs for current timestep
-                
-                //
-                //-----------------------------------------------------------------------------------------------------------------------
-                
-                update_States(state, dt,
-                              k_S0_S1, k_S0_S11,
-                              Ca_cyt_conc,  Ca_sr_conc,
-                              Pi_conc, MgATP_conc, MgADP_conc,
-                              k_S1_S2, k_S1_S0,
-                              k_S2_S3, k_S2_S1,
-                              k_S3_S4, k_S3_S2,
-                              k_S4_S5, k_S4_S3,
-                              k_S5_S6a, k_S5_S4,
-                              k_S5_S6, k_S6_S5,
-                              k_S6a_S7, k_S6a_S5,
-                              k_S7_S8, k_S7_S6a,
-                              k_S7_S6,  k_S6_S7,
-                              k_S8_S9,  k_S8_S7,
-                              k_S9_S10,  k_S9_S8,
-                              k_S10_S11, k_S10_S9,
-                              k_S11_S0, k_S11_S10);
-                
-                //---------------------------------------------------------------
-                // Obtaining Force estimate based on the Markov state @ each time (every 10 timesteps)
-                //---------------------------------------------------------------
-                
-                if (output_count == save_jump)
-                {
-                    if      (state == 0)
-                    {
-                        S0[n/save_jump]   = S0[n/save_jump] + 1.0;
-                    }
-                    else if(state ==1)
-                    {
-                        S1[n/save_jump]   = S1[n/save_jump] + 1.0;
-                    }
-                    else if(state ==2)
-                    {
-                        S2[n/save_jump]   = S2[n/save_jump] + 1.0;
-                    }
-                    else if(state ==3)
-                    {
-                        S3[n/save_jump]   = S3[n/save_jump] + 1.0;
-                    }
-                    else if(state ==4)
-                    {
-                        S4[n/save_jump]   = S4[n/save_jump] + 1.0;
-                    }
-                    else if(state ==5)
-                    {
-                        S5[n/save_jump]   = S5[n/save_jump] + 1.0;
-                    }
-                    else if(state ==6)
-                    {
-                        S6a[n/save_jump]   = S6a[n/save_jump] + 1.0;
-                    }
-                    else if(state ==7)
-                    {
-                        S7[n/save_jump]   = S7[n/save_jump] + 1.0;
-                    }
-                    else if(state ==8)
-                    {
-                        S6[n/save_jump]   = S6[n/save_jump] + 1.0;
-                    }
-                    else if(state ==9)
-                    {
-                        S8[n/save_jump]   = S8[n/save_jump] + 1.0;
-                    }
-                    else if(state ==10)
-                    {
-                        S9[n/save_jump]  = S9[n/save_jump] + 1.0;
-                    }
-                    else if(state ==11)
-                    {
-                        S10[n/save_jump]  = S10[n/save_jump] + 1.0;
-                    }
-                    else if(state ==12)
-                    {
-                        S11[n/save_jump]  = S11[n/save_jump] + 1.0;
-                    }
-                }
-                if (output_count == save_jump)
-                {
-                    output_count = 1;
-                }
-                else
-                {
-                    output_count+=1;
-                }
-            } // end the (n-loop) of the time marching
-            
-            
-        } // end the (r-loop) of the repeat step
-        
-        
-        //counting total number of molecules in each state at every time step
-        //--------------------------------------------------------------------------------------
-        // Calculate The Steady-State Force using Impluse using data from the last 0.5 sec
-        // (i.e., just 10000 time steps, considering we only saved every 10 timesteps) only using numerical trapaziodal integration
-        //--------------------------------------------------------------------------------------
+            ss_Merge(acc_pCa[cal], acc_batch[cal]);
+            ss_Occupancy(acc_batch[cal], SS);
+            batch_bound[cal] = observable(kind[cal], SS);
+        }
+        // the residual of the batch curve as one sample: its spread includes the correlation of the
+        // points (one stream drives the whole curve with --fused-pca)
+        double batch_residual = residual_Of_Data(data, batch_bound);
+        double delta = batch_residual - residual_mean;
+        residual_mean += delta / n_batches;
+        residual_M2   += delta * (batch_residual - residual_mean);
+        molecules_used += n_batch;
+        if (batch == n_SERCA_Molecules || n_batches < adaptive.min_batches || first + n_batch >= n_SERCA_Molecules) continue;
         
-        for (int n = max_tsteps-10000; n < max_tsteps-1; n++)  // time marching
+        //---------------------------------------------
+        // confidence interval of the residual so far
+        //---------------------------------------------
+        for (int cal = 0; cal < n_points; cal++)
         {
-            S0_temp  = S0_temp   +(S0[n/save_jump]  /n_SERCA_Molecules);
-            S1_temp  = S1_temp   +(S1[n/save_jump]  /n_SERCA_Molecules);
-            S2_temp  = S2_temp   +(S2[n/save_jump]  /n_SERCA_Molecules);
-            S3_temp  = S3_temp   +(S3[n/save_jump]  /n_SERCA_Molecules);
-            S4_temp  = S4_temp   +(S4[n/save_jump]  /n_SERCA_Molecules);
-            S5_temp  = S5_temp   +(S5[n/save_jump]  /n_SERCA_Molecules);
-            S6a_temp  = S6a_temp   +(S6a[n/save_jump]  /n_SERCA_Molecules);
-            S7_temp  = S7_temp   +(S7[n/save_jump]  /n_SERCA_Molecules);
-            S6_temp  = S6_temp   +(S6[n/save_jump]  /n_SERCA_Molecules);
-            S8_temp  = S8_temp   +(S8[n/save_jump]  /n_SERCA_Molecules);
-            S9_temp = S9_temp  +(S9[n/save_jump] /n_SERCA_Molecules);
-            S10_temp = S10_temp  +(S10[n/save_jump] /n_SERCA_Molecules);
-            S11_temp = S11_temp  +(S11[n/save_jump] /n_SERCA_Molecules);
-            
+            ss_Occupancy(acc_pCa[cal], SS);
+            ss_bound[cal] = observable(kind[cal], SS);
         }
-        
-        S0_SS  =   S0_temp  / 10000;
-        S1_SS  =   S1_temp  / 10000;
-        S2_SS  =   S2_temp  / 10000;
-        S3_SS  =   S3_temp  / 10000;
-        S4_SS  =   S4_temp  / 10000;
-        S5_SS  =   S5_temp  / 10000;
-        S6a_SS  =   S6a_temp  / 10000;
-        S7_SS  =   S7_temp  / 10000;
-        S6_SS  =   S6_temp  / 10000;
-        S8_SS  =   S8_temp  / 10000;
-        S9_SS =   S9_temp / 10000;
-        S10_SS =   S10_temp / 10000;
-        S11_SS =   S11_temp / 10000;
-        
-        
-        //----------------------------------------------------------
-        // Write time-state data into a text file so we can plot it
-        //----------------------------------------------------------
-       /* std::string filename = "Time_Data.csv";
-        
-        ofstream time_states_out(filename); //opening an output stream for file test.txt
-        if(time_states_out.is_open()) //checking whether file could be opened or not.
+        double sigma    = sqrt(residual_M2 / (n_batches - 1) / n_batches);
+        double estimate = residual_Of_Data(data, ss_bound);
+        if (estimate - adaptive.z * sigma > prune_above)
         {
-            // create headers for file
-            time_states_out << "Time,S0,S1,S2,S3,S4,S5,S6a,S7,S6,S8,S9,S10,S11" << endl; // write the average force
-            for (int n = 0; n < (max_tsteps-1)/save_jump; n++)  // time marching
-            {
-                
-                Time [n] = (n*save_jump*dt);
-                time_states_out << Time [n] << "," << S0[n] << "," << S1[n] << "," << S2[n] << "," << S3[n] << "," << S4[n] << "," << S5[n] << "," << S6a[n] << "," << S7[n] << "," << S6[n] << "," << S8[n] << "," << S9[n] << "," << S10[n] << "," << S11[n] << endl; // write the average force
-            }
-            cout << "Array data successfully saved into the file " << filename << endl;
-        }*/
-        
-        //----------------------------------------------------------
-        // Write SS data into a text file
-        //----------------------------------------------------------
-        /*std::string filename2 = "SS_Data.csv";
-        
-        ofstream ss_out(filename2); //opening an output stream for file test.txt
-        if(ss_out.is_open()) //checking whether file could be opened or not.
+            pruned = true; // cannot beat its own pbest (nor gbest <= pbest): the exact value does not matter
+            break;
+        }
+        if (adaptive.rel_tol > 0 && adaptive.z * sigma < adaptive.rel_tol * estimate)
         {
-            
-            ss_out << "S0,"   << S0_SS     << endl;
-            ss_out << "S1,"   << S1_SS     << endl;
-            ss_out << "S2,"   << S2_SS     << endl;
-            ss_out << "S3,"   << S3_SS     << endl;
-            ss_out << "S4,"   << S4_SS     << endl;
-            ss_out << "S5,"   << S5_SS     << endl;
-            ss_out << "S6a,"   << S6a_SS     << endl;
-            ss_out << "S7,"   << S7_SS     << endl;
-            ss_out << "S6,"   << S6_SS     << endl;
-            ss_out << "S8,"   << S8_SS     << endl;
-            ss_out << "S9,"  << S9_SS    << endl;
-            ss_out << "S10,"  << S10_SS    << endl;
-            ss_out << "S11,"  << S11_SS    << endl;
-            cout << "Array data successfully saved into the file " << filename2 << endl;
+            break; // confidence interval tight enough
         }
-        */
-        
-        ss_bound_Ca[cal] = S1_SS + S2_SS + S9_SS + S8_SS + 2* (S3_SS+ S4_SS + S5_SS + S6a_SS + S7_SS + S6_SS);
-    
-    
-            if (ss_bound_Ca[cal] > boundSS_max_temp)
-            {
-                boundSS_max_temp = ss_bound_Ca[cal];
-            }
-    }// end loop through pCa cal
-    
+    }
     
-       //another loop to normalize - divide by largest number
-    for (int cal2 = 0; cal2 < n_pCa; cal2++)
+    for (int cal = 0; cal < n_points; cal++)
     {
-        norm_ss_bound_Ca[cal2] = ss_bound_Ca[cal2] / boundSS_max_temp;
+        ss_Occupancy(acc_pCa[cal], SS);
+        ss_bound[cal] = observable(kind[cal], SS);
     }
     
     //-------------------------------------
     // Formulate Residual/Cost Function :
     //--------------------------------------
-    double residual_temp = 0.0;
-    for (int cc = 0; cc < n_pCa; cc++)  // Ca-loop
+    residual = residual_Of_Data(data, ss_bound);
+    if (state != NULL)
     {
-        residual_temp = residual_temp + pow ((norm_bound_Ca_Exp[cc] - norm_ss_bound_Ca[cc]),2); // normalized force
-// residual_temp = residual_temp + pow (((norm_bound_Ca_Exp[cc] - norm_ss_bound_Ca[cc])/boundSS_max_temp),2); // normalized force
+        state->stream_id   = stream_id;
+        state->n_molecules = molecules_used;
+        state->n_batches   = n_batches;
+        state->pruned      = pruned;
+        state->residual    = residual;
+        state->acc.assign(acc_pCa, acc_pCa + n_points);
+        state->residual_mean = residual_mean;
+        state->residual_M2   = residual_M2;
     }
-    residual = pow(residual_temp,0.5);
-    cout << " " << std::endl;
-    cout << "       Residual being passed on : " << residual << std::endl;
+    if (config.verbose)
+    {
+        cout << " " << std::endl;
+        cout << "       Residual being passed on : " << residual;
+        if (molecules_used < n_SERCA_Molecules)
+        {
+            cout << "   (" << molecules_used << " molecules" << (pruned ? ", pruned" : "") << ")";
+        }
+        cout << std::endl;
+    }
+    PERF_CALL_END(config.verbose);
     
     return residual;
     
 } // end function
+
+//--------------------------------------------------------------------------//
+
+void get_Residual_Swarm(const serca_Model * models, int n_models, const sim_Config & config, const exp_Data & data,
+                        unsigned long long seed, const unsigned int * stream_ids, float * residuals
+                        )
+
+{
+    const int n_points = data.n_points;
+    if (n_models <= 0 || n_points <= 0 || n_points > max_Data_Points) return;
+    PERF_CALL_BEGIN;
+    sim_Workspace &ws = worker_Workspace();
+    std::vector<transition_Table> &tables  = ws.swarm_tables;
+    std::vector<ss_Accumulator>   &acc     = ws.swarm_acc;
+    std::vector<unsigned int>     &streams = ws.swarm_streams;
+    std::vector<int>              &pCa     = ws.swarm_pCa;
+    if ((int)tables.size() < n_models * n_points) // grows with the swarm, then stays
+    {
+        tables.resize(n_models * n_points);
+        acc.resize(n_models * n_points);
+        streams.resize(n_models * n_points);
+        pCa.resize(n_models * n_points);
+    }
+    for (int m = 0; m < n_models; m++)
+    {
+        build_Data_Tables(&tables[m * n_points], models[m], data);
+        for (int cal = 0; cal < n_points; cal++)
+        {
+            ss_Clear(acc[m * n_points + cal]);
+            streams[m * n_points + cal] = stream_ids[m];
+            pCa    [m * n_points + cal] = cal;
+        }
+    }
+    
+    //-----------------------
+    // SIMULATION FOR SS CURVES: every model and data point in one GPU launch, else model by model
+    //-----------------------
+    bool done = config.engine == ENGINE_GPU &&
+                gpu_Accumulate(&tables[0], n_models * n_points, &streams[0], &pCa[0], seed, 0, config.n_molecules, config.window, &acc[0]);
+    for (int m = 0; m < n_models && !done; m++)
+    {
+        engine_Accumulate_Sweep(config, &tables[m * n_points], n_points, models[m].dt, seed, stream_ids[m], 0, config.n_molecules, &acc[m * n_points]);
+    }
+    
+    for (int m = 0; m < n_models; m++)
+    {
+        float  SS[n_States];
+        float *ss_bound = ws.bound;
+        for (int d = 0; d < data.n_datasets; d++)
+        {
+            for (int cal = data.set[d].first; cal < data.set[d].first + data.set[d].n_points; cal++)
+            {
+                ss_Occupancy(acc[m * n_points + cal], SS);
+                ss_bound[cal] = observable(data.set[d].kind, SS);
+            }
+        }
+        residuals[m] = residual_Of_Data(data, ss_bound);
+        if (config.verbose)
+        {
+            cout << " " << std::endl;
+            cout << "       Residual being passed on : " << residuals[m] << std::endl;
+        }
+    }
+    PERF_CALL_END(config.verbose);
+} // end function
@@ -1,10 +1,55 @@
-float get_Residual  (int    & n_SERCA_Molecules,
-                     int    & max_tsteps,
-                     float  & dt,
-                     int    & n_s,
-                     int    & n_pCa,
-                     float  & k_S0_S1,
-                     float  & k_S2_S3,
-                     float  & k_S7_S8,
-                     float  & k_S9_S10,float  & k_S1_S0, float  & k_S1_S2,  float  & k_S2_S1, float  & k_S3_S2, float  & k_S3_S4,  float  & k_S4_S3, float  & k_S4_S5, float  & k_S5_S4, float  & k_S5_S6a,  float  & k_S6a_S5, float  & k_S6a_S7, float  & k_S7_S6a, float  & k_S5_S6,  float  & k_S6_S5, float  & k_S6_S7, float  & k_S7_S6,  float  & k_S8_S7, float  & k_S8_S9, float  & k_S9_S8,float  & k_S10_S9, float  & k_S10_S11,float  & k_S11_S10,float  & k_S11_S0,float  & k_S0_S11,float  & Ca_sr_conc,float  & MgATP_conc,float  & MgADP_conc, float  & Pi_conc
+#ifndef GET_RESIDUAL_H
+#define GET_RESIDUAL_H
+
+#include <vector>
+#include "serca_Model.h"
+#include "steady_State.h"
+#include "exp_Data.h"
+
+//------------------------------------------------------------------
+// adaptive molecule count (racing): the molecules are simulated in batches for all pCa points and the
+// residual's standard error sigma is estimated from the spread of the residuals of the batch curves
+// (not from per-point errors, which would take the points as independent: with --fused-pca one stream
+// drives the whole curve, so they are correlated). A particle is stopped as soon as
+// residual - z * sigma > prune_above (it cannot improve its pbest), or, if rel_tol > 0, once
+// z * sigma < rel_tol * residual.
+//------------------------------------------------------------------
+struct adaptive_Config
+{
+    bool  enabled;     // --adaptive
+    int   batch;       // molecules per batch and pCa point (--adaptive-batch)
+    int   min_batches; // batches before the first decision, at least 2 (--adaptive-min-batches)
+    float z;           // confidence interval half-width in standard errors (--adaptive-z)
+    float rel_tol;     // relative half-width that is good enough, 0 = only prune (--adaptive-tol)
+};
+
+//------------------------------------------------------------------
+// what get_Residual simulated for one model: enough to continue with more molecules later (residual_Cache).
+// A call given a state with n_molecules > 0 adds molecules n_molecules ... of the state's streams to it.
+//------------------------------------------------------------------
+struct residual_State
+{
+    unsigned int stream_id;   // streams of the molecules simulated so far
+    int          n_molecules; // per data point
+    int          n_batches;   // batches of the adaptive mode
+    bool         pruned;      // stopped early: it could not beat prune_above
+    float        residual;
+    double       residual_mean, residual_M2; // Welford statistics of the batch residuals
+    std::vector<ss_Accumulator> acc;         // per data point
+};
+
+// residual of model against the experimental curves of data: the weighted sum of the curve residuals (the curves
+// are simulated as config says; molecule rr at point cal of the data block draws from stream (stream_id, cal, rr) of seed)
+float get_Residual  (const serca_Model & model, const sim_Config & config, const exp_Data & data,
+                     unsigned long long seed, unsigned int stream_id,
+                     const adaptive_Config & adaptive, float prune_above, int & molecules_used,
+                     residual_State * state = NULL
                      );
+
+// get_Residual of n_models models at once (all molecules, no adaptive stopping): model m uses stream_ids[m].
+// With --engine gpu all models and data points are simulated in one launch.
+void  get_Residual_Swarm(const serca_Model * models, int n_models, const sim_Config & config, const exp_Data & data,
+                         unsigned long long seed, const unsigned int * stream_ids, float * residuals
+                         );
+
+#endif
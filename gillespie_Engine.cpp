@@ -0,0 +1,81 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Exact-jump simulation of the SERCA scheme (see gillespie_Engine.h).
+//
+// With dt = 1e-7 the fixed-dt loop spends almost every step drawing a number that leaves the molecule
+// where it is. Here each molecule only draws at a jump: one number for the waiting time
+// (exponential with the total leaving rate of its state) and one for which branch it takes.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include "rng_Philox.h"
+#include "gillespie_Engine.h"
+#include "perf_Counters.h"
+
+void gillespie_Accumulate(const transition_Table &table, float dt,
+                          unsigned long long seed, unsigned int stream_id, int pCa,
+                          int first_molecule, int n_molecules, double t_begin, double t_end,
+                          ss_Accumulator &acc)
+{
+    PERF_TIMER(KERNEL_GILLESPIE);
+    double leave_rate[n_States];                 // total rate out of each state (1/s)
+    double branch_cum[n_States][max_Branch];     // cumulative branch rates (1/s)
+    for (int s = 0; s < n_States; s++)
+    {
+        double prob[max_Branch + 1];
+        branch_Probabilities(table, s, prob);
+        double sum = 0.0;
+        for (int k = 0; k < max_Branch; k++)
+        {
+            sum += prob[k] / dt;
+            branch_cum[s][k] = sum;
+        }
+        leave_rate[s] = sum;
+    }
+
+    double time_in[n_States] = {0}; // molecule-seconds spent in each state inside the window
+    for (int rr = first_molecule; rr < first_molecule + n_molecules; rr++)
+    {
+        philox_Stream rng;
+        rng_Init(rng, seed, stream_id, pCa, rr);
+        int    state = 0; // every molecule starts in S0 (E)
+        double t     = 0.0;
+        while (t < t_end)
+        {
+            // waiting time in the current state (no way out -> stays until t_end)
+            double t_next = t_end;
+            if (leave_rate[state] > 0.0)
+            {
+                t_next = t - log(1.0 - (double)rng_Uniform(rng)) / leave_rate[state];
+                PERF_ADD(rng_draws, 1);
+            }
+            double from = (t      > t_begin) ? t      : t_begin;
+            double to   = (t_next < t_end)   ? t_next : t_end;
+            if (to > from)
+            {
+                time_in[state] += to - from;
+                PERF_ADD(acc_updates, 1);
+            }
+            t = t_next;
+            if (t >= t_end) break;
+            // which branch: a uniform number on [0, leave_rate)
+            double x = rng_Uniform(rng) * leave_rate[state];
+            int bucket = 0;
+            while (bucket < max_Branch - 1 && x >= branch_cum[state][bucket]) bucket++;
+            PERF_ADD(rng_draws, 1);
+            PERF_ADD(jumps[state], 1);
+            state = table.next[state][bucket];
+        }
+    }
+
+    for (int s = 0; s < n_States; s++)
+    {
+        acc.count[s] += time_in[s] / (t_end - t_begin);
+    }
+    acc.n_samples += n_molecules;
+}
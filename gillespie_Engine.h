@@ -0,0 +1,24 @@
+/*-----------------------------------------------------------------------------------------------------
+// Exact stochastic simulation (Gillespie, direct method) of independent SERCA molecules.
+//
+// The rates are taken from the fixed-dt transition_Table: the probability of branch k per time step
+// (p[s][k] - p[s][k-1] for ordinary tables, see branch_Probabilities) divided by dt. The jump chain and
+// the fixed-dt chain therefore agree in the limit dt -> 0.
+//
+// Every molecule starts in S0 at t = 0 and is run up to t_end. The fraction of the window [t_begin, t_end)
+// it spends in each state is added to acc.count[s] (one sample per molecule), so ss_Occupancy gives the
+// time-weighted occupancy. Molecule rr draws from its Philox stream (stream_id, pCa, rr), two draws per jump.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef GILLESPIE_ENGINE_H
+#define GILLESPIE_ENGINE_H
+
+#include "update_States.h"
+#include "steady_State.h"
+
+void gillespie_Accumulate(const transition_Table &table, float dt,
+                          unsigned long long seed, unsigned int stream_id, int pCa,
+                          int first_molecule, int n_molecules, double t_begin, double t_end,
+                          ss_Accumulator &acc);
+
+#endif
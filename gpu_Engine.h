@@ -0,0 +1,28 @@
+/*-----------------------------------------------------------------------------------------------------
+// The fixed-dt engine on a GPU (--engine gpu), one thread per molecule.
+//
+// gpu_Accumulate simulates molecules [first_molecule, first_molecule + n_molecules) for n_tables
+// transition tables in one launch, as fixed_Dt_Accumulate would for each table, and a whole swarm fits
+// one launch (get_Residual_Swarm). gpu_Select_Device(rank) spreads the MPI ranks of a node over its
+// devices.
+//
+// The device backend is not part of this tree yet: until it is built and validated on a device
+// (./validate), these are the stubs, gpu_Accumulate returns false and every caller uses the CPU.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef GPU_ENGINE_H
+#define GPU_ENGINE_H
+
+#include "steady_State.h"
+
+inline bool        gpu_Available()        { return false; } // a device is present
+inline void        gpu_Select_Device(int) {}
+inline const char *gpu_Device_Name()      { return "not compiled in"; }
+
+inline bool gpu_Accumulate(const transition_Table *, int, const unsigned int *, const int *, unsigned long long,
+                           int, int, const ss_Window &, ss_Accumulator [])
+{
+    return false;
+}
+
+#endif
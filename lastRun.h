@@ -1,10 +1,11 @@
-void lastRun        (int    & n_SERCA_Molecules,
-                     int    & max_tsteps,
-                     float  & dt,
-                     int    & n_s,
-                     int    & n_pCa,
-                     float  & k_S0_S1,
-                     float  & k_S2_S3,
-                     float  & k_S7_S8,
-                     float  & k_S9_S10,float  & k_S1_S0, float  & k_S1_S2,  float  & k_S2_S1, float  & k_S3_S2, float  & k_S3_S4,  float  & k_S4_S3, float  & k_S4_S5, float  & k_S5_S4, float  & k_S5_S6a,  float  & k_S6a_S5, float  & k_S6a_S7, float  & k_S7_S6a, float  & k_S5_S6,  float  & k_S6_S5, float  & k_S6_S7, float  & k_S7_S6,  float  & k_S8_S7, float  & k_S8_S9, float  & k_S9_S8,float  & k_S10_S9, float  & k_S10_S11,float  & k_S11_S10,float  & k_S11_S0,float  & k_S0_S11,float  & Ca_sr_conc,float  & MgATP_conc,float  & MgADP_conc,float  & Pi_conc
+#include "serca_Model.h"
+#include "steady_State.h"
+#include "exp_Data.h"
+
+// the curves of the best model (stream rng_LASTRUN_STREAM), written to best_residual_SSpCa_Curve.csv
+// (Ca dataset) and best_residual_SSPi_Curve.csv (Pi dataset). The points run on the OpenMP threads.
+// With a trajectory_file (fixed-dt engine) the occupancy of all states every trajectory_stride steps is
+// streamed to that file as well (trajectory.h); those points use the fixed window, not --ss-detect
+void lastRun        (const serca_Model & model, const sim_Config & config, const exp_Data & data,
+                     unsigned long long seed, const char *trajectory_file = NULL, int trajectory_stride = 1000
                      );
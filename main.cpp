@@ -44,25 +44,70 @@
 #include <math.h>
 #include <vector>
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <string>
 #include <sstream>
 #include <time.h>
-//#include </usr/include/openmpi-x86_64/mpi.h>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "get_Residual.h"
 #include "lastRun.h"
+#include "checkpoint.h"
+#include "residual_Cache.h"
+#include "gpu_Engine.h"
+#include "telemetry.h"
+#include "perf_Counters.h"
+#include "fidelity.h"
+#include "optimizer.h"
+#include "surrogate.h"
 
 using namespace std;
 
 const int n_particles_PSO = 100;
+const int max_iter = 100;
 
-int   n_s;                 // Number of states
-int   n_pCa ;              // Number of simulated pCa or Ca values
 int   n_SERCA_Molecules;   // Max number used to repeat the simulation
 int   max_tsteps;          // Max number of time stepping
-float dt;                  // fixed time step
 float residual_cost_func[n_particles_PSO]; // to track the residual between numerics and experiments
 float Res_pbest[n_particles_PSO];
+int   molecules_used[n_particles_PSO]; // molecules per pCa point a particle actually needed (adaptive mode)
+float eval_seconds[n_particles_PSO];   // wall time of the last evaluation of each particle (telemetry)
+int   eval_thread[n_particles_PSO];    // OpenMP thread that evaluated it (its rank is i % p)
 int   id, p, ierr, argc; // for parallel    
+unsigned long long run_seed; // every random stream of the simulation is derived from this seed
+simd_Level simd_level = SIMD_AUTO; // vector width used to march the SERCA molecules (--simd)
+sim_Engine sim_engine = ENGINE_FIXED_DT; // how the residual of each particle is computed (--engine)
+sim_Engine last_engine;                  // engine of the final lastRun pass (--last-engine, default: same as --engine)
+sim_Config fit_config, last_config;     // how get_Residual / lastRun simulate the pCa curve (window: --ss-window, --ss-stride, --last-ss-stride)
+serca_Model model;                      // rates and concentrations; the particles only change the four fitted rates
+adaptive_Config adaptive = { false, 500, 4, 3.0f, 0.0f }; // racing molecule count, see get_Residual.h
+long long  n_rand_draws = 0;             // rand() calls so far (pso_Rand), so that a resumed run can replay them
+residual_Cache residual_cache;           // memoized residuals on log-quantized rates (--cache, --cache-max)
+// --crn iteration | run | off (the default): common random numbers, i.e. all particles of an iteration (or of the whole run)
+// draw from the same streams, so their residuals differ by the rates and not by the Monte Carlo noise
+enum crn_Mode { CRN_OFF = 0, CRN_ITERATION, CRN_RUN };
+crn_Mode   crn_mode = CRN_OFF;
+bool       async_pso = false;            // work queue of particle evaluations instead of generations (--async)
+bool       fused_pCa = false;            // fixed-dt: one random stream per molecule for the whole pCa curve (--fused-pca)
+exp_Data   exp_data;                     // the experimental curves, read once by rank 0 (--ca-data, --pi-data, see exp_Data.h)
+int        verbosity = 1;                // console: 0 = settings and gbest per iteration, 1 = also every particle (--verbosity)
+telemetry_Log telemetry = { NULL, "", 0, 0 }; // CSV log of every evaluation, written by rank 0 (--telemetry, --telemetry-flush)
+fidelity_Schedule fidelity = { 0 };      // engine / molecules of the swarm iterations, cheap to full (--fidelity)
+int        fidelity_level = 0;           // the level fit_config is set to
+opt_Method optimizer = OPT_PSO;          // pso | cmaes (--optimizer); the swarm below unless --fit changes the rates
+int        fit_rate[max_Opt_Dim] = { K_S0_S1, K_S2_S3, K_S7_S8, K_S9_S10 }; // rates fitted by the optimizer (--fit)
+int        n_fit = 4;
+int        polish_evals = 0;             // Nelder-Mead evaluations after the fit (--polish)
+int        cmaes_lambda = 0;             // CMA-ES evaluations per generation (--cmaes-lambda, 0: 4 + 3 ln n_fit)
+const double polish_Step = 0.05;         // first simplex edges, fraction of the log10 box (0.1 decades)
+surrogate_Model surrogate;               // predicts the residual of a move before it is simulated (--surrogate)
+bool       screened[n_particles_PSO];    // particle not simulated in this iteration, its residual predicted
+float      predicted[n_particles_PSO];   // ... the predicted residual
 //---------------------------------------------
 // model reference parameters that we need to optimize
 //--------------------------------------------
@@ -97,12 +142,670 @@ float k_S0_S1_gbest   , k_S0_S1_pbest   [n_particles_PSO];
 float k_S2_S3_gbest   , k_S2_S3_pbest   [n_particles_PSO];
 float k_S7_S8_gbest   , k_S7_S8_pbest   [n_particles_PSO];
 float k_S9_S10_gbest , k_S9_S10_pbest [n_particles_PSO];
+float total_gbest[max_iter+1]; // one entry per swarm iteration, it = 0 ... max_iter
 //float k_S5_S6a_gbest   , k_S5_S6a_pbest   [n_particles_PSO];
 //float k_S6_S7_gbest   , k_S6_S7_pbest   [n_particles_PSO];
 //float k_S0_S11_gbest  , k_S0_S11_pbest  [n_particles_PSO];
 // declare all non-changing variables
-float    k_S1_S0, k_S1_S2, k_S2_S1, k_S3_S2, k_S3_S4,  k_S4_S3, k_S4_S5, k_S5_S4, k_S5_S6a,  k_S6a_S5, k_S6a_S7, k_S7_S6a, k_S5_S6,  k_S6_S5, k_S6_S7, k_S7_S6,  k_S8_S7, k_S8_S9, k_S9_S8,k_S10_S9, k_S10_S11,k_S11_S10,k_S11_S0,k_S0_S11;
-float  Ca_sr_conc, MgATP_conc, MgADP_conc, Pi_conc;
+
+
+//----------------------------------------------------------------------------------------------
+// Share the particle positions of rank 0 with all other ranks (only rank 0 draws the random
+// numbers of the PSO updates, so every rank evaluates the same swarm)
+//----------------------------------------------------------------------------------------------
+void broadcast_Positions()
+{
+#ifdef USE_MPI
+    ierr = MPI_Bcast(X_k_S0_S1_PSO,  n_particles_PSO, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    ierr = MPI_Bcast(X_k_S2_S3_PSO,  n_particles_PSO, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    ierr = MPI_Bcast(X_k_S7_S8_PSO,  n_particles_PSO, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    ierr = MPI_Bcast(X_k_S9_S10_PSO, n_particles_PSO, MPI_FLOAT, 0, MPI_COMM_WORLD);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------
+// The PSO random numbers: rand(), counted. The libc state cannot be saved, so a checkpoint keeps
+// the number of draws and a resumed run replays them after srand(seed).
+//----------------------------------------------------------------------------------------------
+int pso_Rand()
+{
+    n_rand_draws++;
+    return rand();
+}
+
+//----------------------------------------------------------------------------------------------
+// Everything the swarm iteration needs to go on, written after every iteration (--checkpoint FILE)
+// and read back by --resume FILE. The simulation streams only depend on the seed and the iteration,
+// so a resumed run continues exactly as the uninterrupted one. The run key (everything up to
+// next_iter) has to match the settings of the resumed run: the fidelity levels, --crn and --adaptive
+// change the residuals, so they are part of it; the other options (--ss-*, ...) must be repeated.
+//----------------------------------------------------------------------------------------------
+struct swarm_State
+{
+    unsigned long long seed;
+    int       key_particles, key_iter, key_molecules, key_tsteps, key_engine, key_topology, key_points; // run key
+    int       key_crn, key_fidelity_levels;
+    int       key_fidelity_engine[max_Fidelity_Levels], key_fidelity_molecules[max_Fidelity_Levels];
+    int       key_adaptive, key_adaptive_batch, key_adaptive_min_batches;
+    float     key_adaptive_z, key_adaptive_tol;
+    int       next_iter; // first swarm iteration still to run (0: right after the initial evaluation)
+    long long n_rand;    // rand() draws made on rank 0
+    float     X[4][n_particles_PSO], V[4][n_particles_PSO], pbest[4][n_particles_PSO];
+    float     Res_pbest[n_particles_PSO];
+    float     gbest[4], Res_gbest;
+    float     total_gbest[max_iter+1];
+};
+
+const int swarm_Rate[4] = { K_S0_S1, K_S2_S3, K_S7_S8, K_S9_S10 }; // the fitted rates, in the order of the arrays below
+float *swarm_X[4]     = { X_k_S0_S1_PSO, X_k_S2_S3_PSO, X_k_S7_S8_PSO, X_k_S9_S10_PSO };
+float *swarm_V[4]     = { V_k_S0_S1_PSO, V_k_S2_S3_PSO, V_k_S7_S8_PSO, V_k_S9_S10_PSO };
+float *swarm_pbest[4] = { k_S0_S1_pbest, k_S2_S3_pbest, k_S7_S8_pbest, k_S9_S10_pbest };
+float *swarm_gbest[4] = { &k_S0_S1_gbest, &k_S2_S3_gbest, &k_S7_S8_gbest, &k_S9_S10_gbest };
+
+void swarm_Key(swarm_State &state)
+{
+    memset(&state, 0, sizeof(state)); // no stray padding bytes in the file
+    state.seed        = run_seed;
+    state.key_particles = n_particles_PSO;
+    state.key_iter      = max_iter;
+    state.key_molecules = n_SERCA_Molecules;
+    state.key_tsteps    = max_tsteps;
+    state.key_engine    = sim_engine;
+    state.key_topology  = model.topology;
+    state.key_points    = exp_data.n_points;
+    state.key_crn       = crn_mode;
+    state.key_fidelity_levels = fidelity.n_levels;
+    for (int l = 0; l < fidelity.n_levels; l++)
+    {
+        state.key_fidelity_engine[l]    = fidelity.level[l].engine;
+        state.key_fidelity_molecules[l] = fidelity.level[l].n_molecules;
+    }
+    if (adaptive.enabled) // the racing settings only matter with --adaptive
+    {
+        state.key_adaptive             = 1;
+        state.key_adaptive_batch       = adaptive.batch;
+        state.key_adaptive_min_batches = adaptive.min_batches;
+        state.key_adaptive_z           = adaptive.z;
+        state.key_adaptive_tol         = adaptive.rel_tol;
+    }
+}
+
+bool save_Swarm(const char *file, int next_iter, float Res_gbest)
+{
+    static swarm_State state;
+    swarm_Key(state);
+    state.next_iter = next_iter;
+    state.n_rand    = n_rand_draws;
+    for (int k = 0; k < 4; k++)
+    {
+        memcpy(state.X[k],     swarm_X[k],     sizeof(state.X[k]));
+        memcpy(state.V[k],     swarm_V[k],     sizeof(state.V[k]));
+        memcpy(state.pbest[k], swarm_pbest[k], sizeof(state.pbest[k]));
+        state.gbest[k] = *swarm_gbest[k];
+    }
+    memcpy(state.Res_pbest,   Res_pbest,   sizeof(state.Res_pbest));
+    memcpy(state.total_gbest, total_gbest, sizeof(state.total_gbest));
+    state.Res_gbest = Res_gbest;
+    return write_Checkpoint(file, &state, sizeof(state));
+}
+
+void restore_Swarm(const swarm_State &state, float &Res_gbest)
+{
+    for (int k = 0; k < 4; k++)
+    {
+        memcpy(swarm_X[k],     state.X[k],     sizeof(state.X[k]));
+        memcpy(swarm_V[k],     state.V[k],     sizeof(state.V[k]));
+        memcpy(swarm_pbest[k], state.pbest[k], sizeof(state.pbest[k]));
+        *swarm_gbest[k] = state.gbest[k];
+    }
+    memcpy(Res_pbest,   state.Res_pbest,   sizeof(state.Res_pbest));
+    memcpy(total_gbest, state.total_gbest, sizeof(state.total_gbest));
+    Res_gbest = state.Res_gbest;
+    srand(state.seed);
+    n_rand_draws = 0;
+    while (n_rand_draws < state.n_rand) pso_Rand();
+}
+
+//----------------------------------------------------------------------------------------------
+// gbest after swarm iterations 0 ... it, written to iterations_vs_global_best.csv (rank 0)
+//----------------------------------------------------------------------------------------------
+void write_Gbest_History(int it)
+{
+    static ofstream iter_out;      // open for the whole run, one line appended per iteration
+    static int      n_written = 0; // iterations already in the file (a resumed run writes the earlier ones first)
+	cout << " " << endl;
+	cout << "The total global best is now : " << total_gbest [it]<< endl;
+	cout << " " << endl;
+
+       // write iteration vs. gbest in a file
+       std::string outfilename = "iterations_vs_global_best.csv";
+       if (!iter_out.is_open())
+       {
+           iter_out.open(outfilename.c_str());
+           iter_out << "iteration  vs  gbest" << '\n';
+       }
+       for (; n_written <= it; n_written++)
+       {
+           iter_out << n_written << "  " << total_gbest[n_written] << '\n';
+       }
+       iter_out.flush();
+       if (iter_out.good()) cout << "Iterations and Global best successfully saved into the file " << outfilename << endl;
+}
+
+//----------------------------------------------------------------------------------------------
+// hits / refinements / misses of the residual cache since the last report, summed over the ranks
+// (all ranks call it, rank 0 prints)
+//----------------------------------------------------------------------------------------------
+void report_Cache()
+{
+    if (!residual_cache.enabled) return;
+    cache_Stats stats = cache_Take_Stats(residual_cache);
+    long long counts[4] = { stats.hits, stats.refined, stats.misses, (long long)residual_cache.entries.size() };
+#ifdef USE_MPI
+    if (p > 1) ierr = MPI_Allreduce(MPI_IN_PLACE, counts, 4, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    if (id == 0) cout << " Residual cache          : " << counts[0] << " hits, " << counts[1] << " refined, " << counts[2]
+                      << " misses (" << counts[3] << " entries)" << endl;
+}
+
+//----------------------------------------------------------------------------------------------
+// kernel counters of the get_Residual calls since the last report, summed over the ranks
+// (make counters only; all ranks call it, rank 0 prints)
+//----------------------------------------------------------------------------------------------
+void report_Counters()
+{
+#ifdef USE_COUNTERS
+    perf_Counters total;
+    perf_Take_Total(total);
+#ifdef USE_MPI
+    if (p > 1) ierr = MPI_Allreduce(MPI_IN_PLACE, &total, perf_Words, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    if (id == 0) perf_Print_Block(cout, total);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------
+// one telemetry line per particle of the evaluation just done (rank 0; iteration -1 = initial swarm)
+//----------------------------------------------------------------------------------------------
+void log_Particles(int iteration)
+{
+    if (id != 0 || telemetry.file == NULL) return;
+    for (int i = 0; i < n_particles_PSO; i++)
+    {
+        telemetry_Record record;
+        record.iteration = iteration;
+        record.particle  = i;
+        record.rank      = i % p;
+        record.thread    = eval_thread[i];
+        for (int k = 0; k < 4; k++) record.rates[k] = swarm_X[k][i];
+        record.residual  = residual_cost_func[i];
+        record.molecules = molecules_used[i];
+        record.seconds   = eval_seconds[i];
+        telemetry_Write(telemetry, record);
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+// stream of particle i in the iteration whose streams start at first_stream = (it+1) * n_particles_PSO
+//----------------------------------------------------------------------------------------------
+unsigned int particle_Stream(unsigned int first_stream, int i)
+{
+    if (crn_mode == CRN_RUN)       return 0;
+    if (crn_mode == CRN_ITERATION) return first_stream;
+    return first_stream + i;
+}
+
+//----------------------------------------------------------------------------------------------
+// Solve for the residual of every particle at its current position.
+// The particles are dealt out round-robin over the MPI ranks (id of p) and each rank spreads
+// its share over the OpenMP threads. The residuals are then summed over all ranks so that
+// every rank holds the full residual_cost_func array before gbest/pbest are updated.
+// Particle i draws its random numbers from stream particle_Stream(first_stream, i) (first_stream + i
+// unless --crn), so the residuals do not depend on the number of threads or ranks.
+// With race_pbest (and --adaptive) a particle stops simulating once it is clearly worse than its pbest.
+// --engine gpu on a device, without --adaptive / --cache: the particles of a rank go to the GPU in one launch.
+// X are the positions evaluated: the particles (swarm_X), or their pbest when the fidelity changes.
+// Particles with skip[i] (--surrogate) are not simulated and keep residual 0.
+//----------------------------------------------------------------------------------------------
+void evaluate_Particles(unsigned int first_stream, bool race_pbest, float *const X[4] = swarm_X, const bool *skip = NULL)
+{
+    for (int i = 0; i < n_particles_PSO; i++)
+    {
+        residual_cost_func[i] = 0.0;
+        molecules_used[i]     = 0;
+        eval_seconds[i]       = 0.0;
+        eval_thread[i]        = 0;
+    }
+
+    if (fit_config.engine == ENGINE_GPU && gpu_Available() && !adaptive.enabled && !residual_cache.enabled)
+    {
+        static serca_Model  swarm[n_particles_PSO];
+        unsigned int        stream_ids[n_particles_PSO];
+        float               residuals[n_particles_PSO];
+        int n_local = 0;
+        int locals[n_particles_PSO];
+        for (int i = id; i < n_particles_PSO; i += p)
+        {
+            if (skip != NULL && skip[i]) continue;
+            locals[n_local] = i;
+            swarm[n_local] = model;
+            for (int k = 0; k < 4; k++) swarm[n_local].rates[swarm_Rate[k]] = X[k][i];
+            stream_ids[n_local] = particle_Stream(first_stream, i);
+            n_local++;
+        }
+        double start = wall_Seconds();
+        get_Residual_Swarm(swarm, n_local, fit_config, exp_data, run_seed, stream_ids, residuals);
+        float seconds = n_local > 0 ? (wall_Seconds() - start) / n_local : 0.0; // one launch, shared evenly
+        for (int m = 0; m < n_local; m++)
+        {
+            int i = locals[m];
+            residual_cost_func[i] = residuals[m];
+            molecules_used[i]     = fit_config.n_molecules;
+            eval_seconds[i]       = seconds;
+        }
+    }
+    else
+    {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (int i = id; i < n_particles_PSO; i += p)
+        {
+            if (skip != NULL && skip[i]) continue;
+            // each particle works on its own copy of the model, with its position as the optimized rates
+            serca_Model particle  = model;
+            particle.rates[K_S0_S1]  = X[0][i];
+            particle.rates[K_S2_S3]  = X[1][i];
+            particle.rates[K_S7_S8]  = X[2][i];
+            particle.rates[K_S9_S10] = X[3][i];
+            float prune_above     = race_pbest ? Res_pbest[i] : HUGE_VALF;
+
+            double start = wall_Seconds();
+            residual_cost_func[i] = cached_Residual(residual_cache, particle, fit_config, exp_data,
+                                                   run_seed, particle_Stream(first_stream, i),
+                                                   adaptive, prune_above, molecules_used[i]
+                                                   );
+            eval_seconds[i] = wall_Seconds() - start;
+#ifdef _OPENMP
+            eval_thread[i]  = omp_get_thread_num();
+#endif
+        }
+    }
+
+#ifdef USE_MPI
+    ierr = MPI_Allreduce(MPI_IN_PLACE, residual_cost_func, n_particles_PSO, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+    ierr = MPI_Allreduce(MPI_IN_PLACE, molecules_used, n_particles_PSO, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    ierr = MPI_Allreduce(MPI_IN_PLACE, eval_seconds, n_particles_PSO, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+    ierr = MPI_Allreduce(MPI_IN_PLACE, eval_thread,  n_particles_PSO, MPI_INT,   MPI_SUM, MPI_COMM_WORLD);
+#endif
+    if (adaptive.enabled && id == 0)
+    {
+        long long total = 0;
+        for (int i = 0; i < n_particles_PSO; i++) total += molecules_used[i];
+        cout << " Molecules simulated     : " << total << " of " << (long long)fit_config.n_molecules * n_particles_PSO
+             << " (per pCa point)" << endl;
+    }
+    report_Cache();
+    report_Counters();
+}
+
+
+//----------------------------------------------------------------------------------------------
+// --surrogate, before the evaluation of a move: screened[i] for the particles whose predicted residual
+// cannot reach their pbest (mean - kappa * sigma > Res_pbest); without a surrogate or a prediction
+// every particle is simulated
+//----------------------------------------------------------------------------------------------
+void screen_Particles()
+{
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int i = 0; i < n_particles_PSO; i++)
+    {
+        float position[4], mean, sigma;
+        for (int k = 0; k < 4; k++) position[k] = swarm_X[k][i];
+        screened[i] = surrogate.enabled && surrogate_Predict(surrogate, position, mean, sigma) &&
+                      mean - surrogate.kappa * sigma > Res_pbest[i];
+        predicted[i] = screened[i] ? mean : 0.0f;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+// after it: the screened particles take their predicted residual, the simulated ones go to the archive
+// (X and skip as in evaluate_Particles; skip NULL: every particle was simulated)
+//----------------------------------------------------------------------------------------------
+void learn_Particles(float *const X[4], const bool *skip)
+{
+    if (!surrogate.enabled) return;
+    int n_simulated = 0;
+    for (int i = 0; i < n_particles_PSO; i++)
+    {
+        if (skip != NULL && skip[i])
+        {
+            residual_cost_func[i] = predicted[i];
+            continue;
+        }
+        float position[4];
+        for (int k = 0; k < 4; k++) position[k] = X[k][i];
+        surrogate_Add(surrogate, position, residual_cost_func[i]);
+        n_simulated++;
+    }
+    if (id == 0) cout << " Surrogate               : " << n_simulated << " of " << n_particles_PSO << " particles simulated ("
+                      << surrogate.y.size() << " points learned)" << endl;
+}
+
+//----------------------------------------------------------------------------------------------
+// fidelity level of swarm iteration it (-1: the initial swarm): the inertia weight w = w_min + it*dw
+// has covered it / max_iter of its range
+//----------------------------------------------------------------------------------------------
+int fidelity_At(int it)
+{
+    return fidelity_Index(fidelity, (it > 0 && max_iter > 0) ? (float)it / max_iter : 0.0f);
+}
+
+//----------------------------------------------------------------------------------------------
+// fit_config at level index of the fidelity schedule (nothing without --fidelity)
+//----------------------------------------------------------------------------------------------
+void set_Fidelity(int index)
+{
+    fidelity_level = index;
+    if (fidelity.n_levels == 0) return;
+    fit_config.engine      = fidelity.level[index].engine;
+    fit_config.n_molecules = fidelity.level[index].n_molecules;
+}
+
+//----------------------------------------------------------------------------------------------
+// move the swarm to fidelity level index: the pbest residuals of the old level are not comparable
+// with the new ones, so every pbest position is evaluated again (streams after those of the swarm
+// iterations, one block per level) and gbest becomes the best pbest
+//----------------------------------------------------------------------------------------------
+void raise_Fidelity(int index, float &Res_gbest)
+{
+    set_Fidelity(index);
+    if (id == 0) cout << " Fidelity level " << index+1 << " of " << fidelity.n_levels << "   : "
+                      << fidelity_Name(fidelity.level[index]) << ", pbest re-evaluated" << endl;
+    evaluate_Particles((max_iter + 2 + index) * n_particles_PSO, false, swarm_pbest);
+    surrogate_Clear(surrogate); // residuals of the old level
+    learn_Particles(swarm_pbest, NULL); // all simulated, whatever the last screen skipped
+    int i_best = 0;
+    for (int i = 0; i < n_particles_PSO; i++)
+    {
+        Res_pbest[i] = residual_cost_func[i];
+        if (Res_pbest[i] < Res_pbest[i_best]) i_best = i;
+        if (id == 0 && verbosity >= 1) cout << "       pbest " << i << " re-evaluated   : " << Res_pbest[i] << endl;
+    }
+    Res_gbest = Res_pbest[i_best];
+    for (int k = 0; k < 4; k++) *swarm_gbest[k] = swarm_pbest[k][i_best];
+}
+
+//----------------------------------------------------------------------------------------------
+// Asynchronous swarm (--async): the (max_iter+1) * n_particles_PSO evaluations of the swarm iterations
+// form one work queue instead of max_iter+1 generations. A thread that finishes a particle updates
+// its pbest and gbest at once, then takes the idle particle that is furthest behind, moves it with
+// the current gbest (velocity update as in the synchronous loop, inertia from the particle's own
+// iteration count) and evaluates it, so no thread waits for the slowest particle of an iteration.
+// Particle i in its iteration g draws from stream particle_Stream((g+1) * n_particles_PSO, i), as in the synchronous
+// loop, but the order of the updates (and so the result) depends on the timing of the threads.
+// total_gbest[it] is the gbest after (it+1) * n_particles_PSO evaluations. One MPI rank only.
+//----------------------------------------------------------------------------------------------
+void run_Async_Swarm(float &Res_gbest)
+{
+    const float w_max = 1.0, w_min = 0.3, c1 = 1.05, c2 = 1.05;
+    const float dw    = (max_iter > 0) ? (w_max-w_min)/max_iter : 0.0f;
+    const long long n_evaluations = (long long)(max_iter+1) * n_particles_PSO;
+    long long n_started = 0, n_done = 0;
+    int  iteration[n_particles_PSO]; // swarm iterations particle i has started
+    bool busy     [n_particles_PSO];
+    for (int i = 0; i < n_particles_PSO; i++)
+    {
+        iteration[i] = 0;
+        busy[i]      = false;
+    }
+    int n_workers = 1;
+#ifdef _OPENMP
+    n_workers = omp_get_max_threads();
+#endif
+    if (n_workers > n_particles_PSO) n_workers = n_particles_PSO; // there is always an idle particle
+
+    #pragma omp parallel num_threads(n_workers)
+    {
+        for (;;)
+        {
+            int   i = -1, it = 0;
+            float prune_above = HUGE_VALF;
+            serca_Model particle = model;
+            #pragma omp critical (async_swarm)
+            {
+                if (n_started < n_evaluations)
+                {
+                    n_started++;
+                    for (int j = 0; j < n_particles_PSO; j++)
+                    {
+                        if (!busy[j] && (i < 0 || iteration[j] < iteration[i])) i = j;
+                    }
+                    it = iteration[i]++;
+                    busy[i] = true;
+                    float w = w_min + it*dw;
+                    if (w > w_max) w = w_max;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        swarm_V[k][i] = w * swarm_V[k][i] + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (swarm_pbest[k][i] - swarm_X[k][i])
+                                                          + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (*swarm_gbest[k]    - swarm_X[k][i]);
+                        swarm_X[k][i] = swarm_X[k][i] + swarm_V[k][i];
+                    }
+                    for (int k = 0; k < 4; k++) particle.rates[swarm_Rate[k]] = swarm_X[k][i];
+                    prune_above = Res_pbest[i];
+                }
+            }
+            if (i < 0) break; // queue empty
+
+            int    used;
+            double start    = wall_Seconds();
+            float  residual = cached_Residual(residual_cache, particle, fit_config, exp_data,
+                                              run_seed, particle_Stream((it+1)*n_particles_PSO, i),
+                                              adaptive, prune_above, used);
+            double seconds  = wall_Seconds() - start;
+
+            #pragma omp critical (async_swarm)
+            {
+                busy[i]               = false;
+                residual_cost_func[i] = residual;
+                molecules_used[i]     = used;
+                if (residual <= Res_pbest[i])
+                {
+                    for (int k = 0; k < 4; k++) swarm_pbest[k][i] = particle.rates[swarm_Rate[k]];
+                    Res_pbest[i] = residual;
+                }
+                if (residual <= Res_gbest)
+                {
+                    for (int k = 0; k < 4; k++) *swarm_gbest[k] = swarm_pbest[k][i];
+                    Res_gbest = residual;
+                }
+                if (verbosity >= 1)
+                {
+                    cout << " Particle # " << i+1 << " (iteration " << it << ")" << '\n';
+                    cout << "        k_S0_S1 = " << particle.rates[K_S0_S1] << ", k_S2_S3 = " << particle.rates[K_S2_S3]
+                         << ", k_S7_S8 = " << particle.rates[K_S7_S8] << ", k_S9_S10 = " << particle.rates[K_S9_S10] << '\n';
+                    cout << " Residual =  " << residual << '\n';
+                }
+                if (telemetry.file != NULL)
+                {
+                    telemetry_Record record;
+                    record.iteration = it;
+                    record.particle  = i;
+                    record.rank      = 0;
+#ifdef _OPENMP
+                    record.thread    = omp_get_thread_num();
+#else
+                    record.thread    = 0;
+#endif
+                    for (int k = 0; k < 4; k++) record.rates[k] = particle.rates[swarm_Rate[k]];
+                    record.residual  = residual;
+                    record.molecules = used;
+                    record.seconds   = seconds;
+                    telemetry_Write(telemetry, record);
+                }
+                n_done++;
+                if (n_done % n_particles_PSO == 0)
+                {
+                    int done_iter = (int)(n_done / n_particles_PSO) - 1;
+                    total_gbest[done_iter] = Res_gbest;
+                    write_Gbest_History(done_iter);
+                    report_Cache();
+                    report_Counters();
+                }
+            }
+        }
+    }
+}
+
+
+//----------------------------------------------------------------------------------------------
+// Batch callback of the optimizers (optimizer.h): the points are dealt out over the ranks and
+// threads like the particles in evaluate_Particles, and point j sets the rates fit_rate[k] to
+// 10^x[j * n_dim + k]. No pbest racing (the optimizers keep no per-point history).
+//----------------------------------------------------------------------------------------------
+void evaluate_Batch(int n, int n_dim, const double *x, const unsigned int *streams, float *residual, void *)
+{
+    for (int j = 0; j < n; j++) residual[j] = 0.0;
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int j = id; j < n; j += p)
+    {
+        serca_Model point = model;
+        for (int k = 0; k < n_dim; k++) point.rates[fit_rate[k]] = (float)pow(10.0, x[j * n_dim + k]);
+        int used;
+        residual[j] = cached_Residual(residual_cache, point, fit_config, exp_data, run_seed,
+                                      crn_mode == CRN_RUN ? 0 : streams[j], adaptive, HUGE_VALF, used);
+    }
+#ifdef USE_MPI
+    ierr = MPI_Allreduce(MPI_IN_PLACE, residual, n, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+#endif
+    report_Cache();
+    report_Counters();
+}
+
+//----------------------------------------------------------------------------------------------
+// progress of the optimizers: console, and best residual vs. evaluations in optimizer_history.csv (rank 0)
+//----------------------------------------------------------------------------------------------
+void report_Optimizer(const char *method, int step, long long n_evals, float best, void *)
+{
+    if (id != 0) return;
+    static ofstream history;
+    if (!history.is_open())
+    {
+        history.open("optimizer_history.csv");
+        history << "evaluations  vs  gbest" << '\n';
+    }
+    history << n_evals << "  " << best << '\n';
+    history.flush();
+    cout << " " << method << " step " << step << " : best residual " << best << " after " << n_evals << " evaluations" << endl;
+}
+
+//----------------------------------------------------------------------------------------------
+// --fit k_S0_S1,k_S5_S6a,... : the rates of the optimizer, by rate_Name
+//----------------------------------------------------------------------------------------------
+bool parse_Fit(const string &spec, string &error)
+{
+    n_fit = 0;
+    stringstream in(spec);
+    string name;
+    while (getline(in, name, ','))
+    {
+        int r = 0;
+        while (r < n_Rates && name != rate_Name(r)) r++;
+        if (r == n_Rates)
+        {
+            error = "unknown rate " + name + " in --fit " + spec;
+            return false;
+        }
+        for (int k = 0; k < n_fit; k++)
+        {
+            if (fit_rate[k] == r)
+            {
+                error = name + " twice in --fit " + spec;
+                return false;
+            }
+        }
+        if (!(model.rates[r] > 0.0f))
+        {
+            error = name + " is 0 in the model and cannot be fitted in log space";
+            return false;
+        }
+        fit_rate[n_fit++] = r;
+    }
+    if (n_fit == 0) error = "no rates in --fit " + spec;
+    return n_fit > 0;
+}
+
+//----------------------------------------------------------------------------------------------
+// the fitted rates as an optimizer problem: log10 of 0.1x ... 10x the reference rates (the bounds of
+// the swarm), evaluations from first_stream on
+//----------------------------------------------------------------------------------------------
+void fit_Problem(opt_Problem &problem, long long max_evals, unsigned int first_stream)
+{
+    problem.n_dim = n_fit;
+    for (int k = 0; k < n_fit; k++)
+    {
+        problem.lower[k] = log10(0.1  * model.rates[fit_rate[k]]);
+        problem.upper[k] = log10(10.0 * model.rates[fit_rate[k]]);
+    }
+    problem.evaluate       = evaluate_Batch;
+    problem.progress       = report_Optimizer;
+    problem.user           = NULL;
+    problem.seed           = run_seed;
+    problem.first_stream   = first_stream;
+    problem.common_streams = crn_mode != CRN_OFF;
+    problem.max_evals      = max_evals;
+}
+
+//----------------------------------------------------------------------------------------------
+// Nelder-Mead from the rates of best (--polish); best gets the polished rates. Streams after those of
+// the swarm iterations and the fidelity levels.
+//----------------------------------------------------------------------------------------------
+float polish_Rates(serca_Model &best, long long first_stream)
+{
+    opt_Problem problem;
+    fit_Problem(problem, polish_evals, (unsigned int)first_stream);
+    opt_Result result;
+    result.n_evals = 0;
+    for (int k = 0; k < n_fit; k++)
+    {
+        float rate  = best.rates[fit_rate[k]];
+        result.x[k] = (rate > 0.0f) ? log10((double)rate) : problem.lower[k]; // a swarm position may be < 0
+    }
+    nelder_Mead_Polish(problem, polish_Step, result);
+    for (int k = 0; k < n_fit; k++) best.rates[fit_rate[k]] = (float)pow(10.0, result.x[k]);
+    if (id == 0) cout << " Nelder-Mead polish      : residual " << result.residual << " after " << result.n_evals << " evaluations" << endl;
+    return result.residual;
+}
+
+//----------------------------------------------------------------------------------------------
+// --optimizer cmaes, or any --fit other than the four rates of the swarm: the optimizer of optimizer.h
+// with the budget of the swarm ((max_iter+2) * n_particles_PSO evaluations), the polish, then the
+// final pass with the best rates
+//----------------------------------------------------------------------------------------------
+void run_Optimizer(long long startTime, const char *trajectory_file, int trajectory_stride)
+{
+    const long long budget = (long long)(max_iter + 2) * n_particles_PSO;
+    opt_Problem problem;
+    fit_Problem(problem, budget, 0);
+    opt_Result result;
+    if (optimizer == OPT_CMAES) cmaes_Minimize(problem, cmaes_lambda, result);
+    else                        pso_Minimize(problem, n_particles_PSO, result);
+
+    serca_Model best = model;
+    for (int k = 0; k < n_fit; k++) best.rates[fit_rate[k]] = (float)pow(10.0, result.x[k]);
+    float Res_gbest = result.residual;
+    if (polish_evals > 0) Res_gbest = polish_Rates(best, budget);
+    telemetry_Close(telemetry);
+    if (id == 0)
+    {
+        cout << "\"Res_gbest\"," << Res_gbest << endl;
+        for (int k = 0; k < n_fit; k++)
+        {
+            cout << "\"" << rate_Name(fit_rate[k]) << "_gbest\"," << best.rates[fit_rate[k]] << " original Inesi value " << model.rates[fit_rate[k]] << endl;
+        }
+        cout << " Optimizer               : " << opt_Method_Name(optimizer) << ", " << result.n_evals << " residual evaluations" << endl;
+        cout << "Total Optimization Runtime: " << (time(NULL)-startTime) << " second(s)" << endl;
+        lastRun(best, last_config, exp_data, run_seed, trajectory_file, trajectory_stride);
+    }
+}
 
 
 //-------------------------
@@ -110,13 +813,19 @@ float  Ca_sr_conc, MgATP_conc, MgADP_conc, Pi_conc;
 //------------------------
 int main(int argc, char *argv[])
 {
-    
+    id = 0; // rank of this process
+    p  = 1; // number of processes
+#ifdef USE_MPI
+    ierr = MPI_Init(&argc, &argv);
+    ierr = MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    ierr = MPI_Comm_size(MPI_COMM_WORLD, &p);
+#endif
+    gpu_Select_Device(id);
+
     long long startTime    = time(NULL);
     n_SERCA_Molecules      = 10000;         // Max number used to repeat the simulation (n_SERCA)
     max_tsteps             = 100001;     // Max number of time stepping
-    dt                     = 1e-7;       // fixed time step
-    n_s          	   = 12 ;         // Number of states
-    n_pCa       	   = 16;         // Number of  pCa or Ca values to be simulated
+    model                  = inesi_Model(); // reference rates and concentrations, dt = 1e-7 (see serca_Model.cpp)
     // --------------------------------------------------------------------------------------------------
     // Parameters / reference values of the transition rates (will be optimized)
     // Lower and Upper bounds on each parameter. NB: upper = 1.5* lower i.e, 50 % increase of lower value
@@ -141,46 +850,493 @@ int main(int argc, char *argv[])
     /*----------------------------*/
     /* Assign Model parameters    */
     /*----------------------------*/
-    Ca_sr_conc        = 1.3e-3;// needs citation
-    MgATP_conc        = 5e-3;  // needs citation
-    MgADP_conc        = 36e-6; // needs citation
-    Pi_conc           = 1e-3;  // needs citation
-    
-    //k_S0_S1           = 4e7;   // Transition rate of  E to E.Ca                       Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
-    k_S1_S0           = 4.5e2;  // Transition rate of  E.Ca to E                       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S1_S2           = 120;   // Transition rate of  E.Ca to E'.Ca                   Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S2_S1           = 25;    // Transition rate of  E'.Ca to E.Ca                   Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    //k_S2_S3           = 1e8;   // Transition rate of  E'.Ca to E'.Ca2                 Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
-    k_S3_S2           = 16;    // Transition rate of  E'.Ca2 to E'.Ca                 Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S3_S4           = 6e7;   // Transition rate of  E'.Ca2 to E'.ATP.Ca2            Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
-    k_S4_S3           = 30;    // Transition rate of  E'.ATP.Ca2 to E'.Ca2            Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S4_S5           = 200;   // Transition rate of  E'.ATP.Ca2 to E'~P.ADP.Ca2      Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S5_S4           = 350;   // Transition rate of  E'~P.ADP.Ca2 to E'.ATP.Ca2      Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S5_S6a           = 800;   // Transition rate of  E'~P.ADP.Ca2 to *E'-P.ADP.Ca2   Units (s^-1)      Inesi Methods in Enzymo gy (1988) 157:154-190
-    k_S6a_S5           = 200;   // Transition rate of *E'-P.ADP.Ca2 to E'~P.ADP.Ca2    Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S6a_S7           = 500;   // Transition rate of *E'-P.ADP.Ca2 to *E'-P.Ca2       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S7_S6a           = 4e6;   // Transition rate of *E'-P.Ca2 to *E'.ADP-P.Ca2       Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
-    k_S5_S6           = 6;     // Transition rate of *E'~P.ADP.Ca2 to E'~P.Ca2        Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S6_S5           = 1.25e3;// Transition rate of  E'~P.Ca2 to *E'~P.ADP.Ca2       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S6_S7           = 1;     // Transition rate of  E'~P.Ca2 to *E'-P.Ca2           Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S7_S6           = 10;    // Transition rate of *E'-P.Ca2 to E'~P.Ca2            Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    //k_S7_S8           = 500;   // Transition rate of *E'-P.Ca2 to *E-P.Ca2            Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S8_S7           = 5e5;   // Transition rate of *E-P.Ca2 to *E'-P.Ca2            Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
-    k_S8_S9          = 20;    // Transition rate of *E-P.Ca2 to *E-P.Ca              Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S9_S8          = 20;    // Transition rate of *E-P.Ca to *E-P.Ca2              Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    //k_S9_S10         = 6e2;   // Transition rate of *E-P.Ca to *E-P                  Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S10_S9         = 6e4;   // Transition rate of *E-P to *E-P.Ca                  Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
-    k_S10_S11         = 60;    // Transition rate of *E-P to *E-Pi                    Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S11_S10         = 60;    // Transition rate of *E-Pi to *E-P                    Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S11_S0          = 6e2;   // Transition rate of *E-Pi to E                       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
-    k_S0_S11          = 1.5e4; // Transition rate of  E to *E-Pi                      Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    // all rates and concentrations are the Inesi reference values of inesi_Model(); the particles
+    // replace k_S0_S1, k_S2_S3, k_S7_S8 and k_S9_S10 (evaluate_Particles)
     //end parameter setup
     
     
     
     
   
-    srand(time(NULL)); //Random-Seed initialization (must be outside any loop)
+    //---------------------------------------------------------------------------------
+    // Random-Seed initialization (must be outside any loop): ./main --seed N repeats a run
+    //---------------------------------------------------------------------------------
+    run_seed = time(NULL);
+    string unknown_engine; // --engine / --last-engine names parse_Sim_Engine does not know
+    string unknown_simd;   // ... and --simd levels
+    for (int a = 1; a < argc; a++)
+    {
+        if (string(argv[a]) == "--seed" && a+1 < argc)
+        {
+            run_seed = strtoull(argv[++a], NULL, 10);
+        }
+        else if (string(argv[a]) == "--simd" && a+1 < argc) // auto | scalar | avx2 | avx512
+        {
+            if (!parse_Simd_Level(argv[++a], simd_level)) unknown_simd = argv[a];
+        }
+        else if (string(argv[a]) == "--engine" && a+1 < argc) // fixed | gillespie | cme | cme-ss | gpu | population
+        {
+            if (!parse_Sim_Engine(argv[++a], sim_engine)) unknown_engine = argv[a];
+        }
+    }
+    // e.g. --engine cme --last-engine fixed : fit on the master equation, check the best rates stochastically
+    last_engine = sim_engine;
+    int ss_window_steps = 10000; // steady state = the last ss_window_steps time steps
+    int ss_stride       = 1000;  // fixed-dt: sample the molecules every ss_stride steps inside the window
+    int last_ss_stride  = 100;   // same for the final lastRun pass
+    bool  ss_detect     = false; // find the window from the drift of the occupancy instead (fixed-dt)
+    int   detect_block  = 0;     // its samples per block average, tolerance and effective samples (0: defaults)
+    float detect_tol    = 0, detect_neff = 0;
+    string ca_data_file = "exp_Calcium.dat"; // bound Ca vs Ca_cyt_conc, always fitted
+    string pi_data_file;                     // bound Pi vs Pi_conc, fitted only if given
+    float  ca_weight    = 1.0f;  // weights of the curve residuals
+    float  pi_weight    = 1.0f;
+    float  pi_Ca_cyt    = 1e-9f; // Ca_cyt_conc of the Pi curve (M): Ca-free (EGTA) phosphorylation by Pi
+    float  cache_resolution = 0; // residual cache bin width in log10 k, 0 = no cache
+    long   cache_max    = 16384; // residual cache entries
+    string checkpoint_file;      // swarm state written after every iteration
+    string resume_file;          // continue the run saved in this checkpoint
+    string telemetry_file;       // CSV line per particle evaluation
+    double telemetry_flush = 30; // seconds between telemetry writes
+    string trajectory_file;      // time courses of the final pass
+    int    trajectory_stride = 1000; // time steps between their frames
+    string fidelity_spec;        // levels of the swarm iterations, e.g. cme,1000,3000
+    string optimizer_name;       // pso | cmaes
+    string fit_spec;             // rates of the optimizer, e.g. k_S0_S1,k_S2_S3,k_S5_S6a
+    string crn_spec;             // iteration | run | off
+    string unknown_topology;     // a --topology parse_Topology does not know
+    bool   use_surrogate = false;
+    float  surrogate_kappa = 2.0f;   // simulate if mean - kappa * sigma <= pbest
+    int    surrogate_neighbours = 32; // archived points of a prediction
+    for (int a = 1; a < argc; a++)
+    {
+        if (string(argv[a]) == "--last-engine" && a+1 < argc)
+        {
+            if (!parse_Sim_Engine(argv[++a], last_engine)) unknown_engine = argv[a];
+        }
+        else if (string(argv[a]) == "--ss-window" && a+1 < argc)
+        {
+            ss_window_steps = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--ss-stride" && a+1 < argc)
+        {
+            ss_stride = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--last-ss-stride" && a+1 < argc)
+        {
+            last_ss_stride = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--ss-detect")
+        {
+            ss_detect = true;
+        }
+        else if (string(argv[a]) == "--ss-detect-block" && a+1 < argc)
+        {
+            detect_block = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--ss-detect-tol" && a+1 < argc) // e.g. 0.02: occupancies within 2 %
+        {
+            detect_tol = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--ss-detect-neff" && a+1 < argc) // effective samples per molecule
+        {
+            detect_neff = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--topology" && a+1 < argc) // inesi | no-s6
+        {
+            if (!parse_Topology(argv[++a], model.topology)) unknown_topology = argv[a];
+        }
+        else if (string(argv[a]) == "--ca-data" && a+1 < argc)
+        {
+            ca_data_file = argv[++a];
+        }
+        else if (string(argv[a]) == "--pi-data" && a+1 < argc) // e.g. exp_Phosphate.dat
+        {
+            pi_data_file = argv[++a];
+        }
+        else if (string(argv[a]) == "--ca-weight" && a+1 < argc)
+        {
+            ca_weight = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--pi-weight" && a+1 < argc)
+        {
+            pi_weight = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--pi-ca" && a+1 < argc)
+        {
+            pi_Ca_cyt = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--checkpoint" && a+1 < argc)
+        {
+            checkpoint_file = argv[++a];
+        }
+        else if (string(argv[a]) == "--resume" && a+1 < argc)
+        {
+            resume_file = argv[++a];
+        }
+        else if (string(argv[a]) == "--cache" && a+1 < argc) // e.g. 0.002: rates within 0.5 % share a residual
+        {
+            cache_resolution = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--cache-max" && a+1 < argc)
+        {
+            cache_max = atol(argv[++a]);
+        }
+        else if (string(argv[a]) == "--crn" && a+1 < argc) // iteration | run | off
+        {
+            crn_spec = argv[++a];
+        }
+        else if (string(argv[a]) == "--verbosity" && a+1 < argc) // 0 | 1
+        {
+            verbosity = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--telemetry" && a+1 < argc) // e.g. telemetry.csv
+        {
+            telemetry_file = argv[++a];
+        }
+        else if (string(argv[a]) == "--telemetry-flush" && a+1 < argc)
+        {
+            telemetry_flush = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--trajectory" && a+1 < argc) // e.g. best_trajectory.bin
+        {
+            trajectory_file = argv[++a];
+        }
+        else if (string(argv[a]) == "--trajectory-stride" && a+1 < argc)
+        {
+            trajectory_stride = atoi(argv[++a]);
+            if (trajectory_stride < 1) trajectory_stride = 1;
+        }
+        else if (string(argv[a]) == "--fidelity" && a+1 < argc) // e.g. cme,1000,3000
+        {
+            fidelity_spec = argv[++a];
+        }
+        else if (string(argv[a]) == "--optimizer" && a+1 < argc) // pso | cmaes
+        {
+            optimizer_name = argv[++a];
+        }
+        else if (string(argv[a]) == "--fit" && a+1 < argc) // e.g. k_S0_S1,k_S2_S3,k_S7_S8,k_S9_S10,k_S5_S6a
+        {
+            fit_spec = argv[++a];
+        }
+        else if (string(argv[a]) == "--polish" && a+1 < argc) // Nelder-Mead evaluations after the fit
+        {
+            polish_evals = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--cmaes-lambda" && a+1 < argc)
+        {
+            cmaes_lambda = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--surrogate")
+        {
+            use_surrogate = true;
+        }
+        else if (string(argv[a]) == "--surrogate-kappa" && a+1 < argc)
+        {
+            surrogate_kappa = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--surrogate-neighbours" && a+1 < argc)
+        {
+            surrogate_neighbours = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--async")
+        {
+            async_pso = true;
+        }
+        else if (string(argv[a]) == "--fused-pca")
+        {
+            fused_pCa = true;
+        }
+        else if (string(argv[a]) == "--adaptive")
+        {
+            adaptive.enabled = true;
+        }
+        else if (string(argv[a]) == "--adaptive-batch" && a+1 < argc)
+        {
+            adaptive.batch = atoi(argv[++a]);
+        }
+        else if (string(argv[a]) == "--adaptive-min-batches" && a+1 < argc)
+        {
+            adaptive.min_batches = atoi(argv[++a]);
+            if (adaptive.min_batches < 2) adaptive.min_batches = 2; // sigma needs the spread of two batches
+        }
+        else if (string(argv[a]) == "--adaptive-z" && a+1 < argc)
+        {
+            adaptive.z = atof(argv[++a]);
+        }
+        else if (string(argv[a]) == "--adaptive-tol" && a+1 < argc)
+        {
+            adaptive.rel_tol = atof(argv[++a]);
+        }
+    }
+    simd_level = resolve_Simd_Level(simd_level);
+    fit_config.n_molecules = n_SERCA_Molecules;
+    fit_config.max_tsteps  = max_tsteps;
+    fit_config.window      = make_Window(max_tsteps, ss_window_steps, ss_stride);
+    if (ss_detect) enable_Detection(fit_config.window, detect_block, detect_tol, detect_neff);
+    fit_config.engine      = sim_engine;
+    fit_config.simd        = simd_level;
+    fit_config.fused_pCa   = fused_pCa;
+    fit_config.verbose     = verbosity >= 1;
+    last_config            = fit_config;
+    last_config.window     = make_Window(max_tsteps, ss_window_steps, last_ss_stride);
+    if (ss_detect) enable_Detection(last_config.window, detect_block, detect_tol, detect_neff);
+    last_config.engine     = last_engine;
+    if (!unknown_topology.empty())
+    {
+        if (id == 0) cout << " Model topology          : unknown topology " << unknown_topology << " (inesi | no-s6)" << endl;
+#ifdef USE_MPI
+        ierr = MPI_Finalize();
+#endif
+        return 1;
+    }
+    if (!unknown_simd.empty())
+    {
+        if (id == 0) cout << " SIMD level              : unknown level " << unknown_simd << " (auto | scalar | avx2 | avx512)" << endl;
+#ifdef USE_MPI
+        ierr = MPI_Finalize();
+#endif
+        return 1;
+    }
+    if (!unknown_engine.empty())
+    {
+        if (id == 0) cout << " Simulation engine       : unknown engine " << unknown_engine
+                          << " (fixed | gillespie | cme | cme-ss | gpu | population)" << endl;
+#ifdef USE_MPI
+        ierr = MPI_Finalize();
+#endif
+        return 1;
+    }
+    if (!fidelity_spec.empty())
+    {
+        fidelity_Level full = { sim_engine, n_SERCA_Molecules };
+        string error;
+        if (!parse_Fidelity(fidelity, fidelity_spec.c_str(), full, error))
+        {
+            if (id == 0) cout << " Fidelity schedule       : " << error << endl;
+#ifdef USE_MPI
+            ierr = MPI_Finalize();
+#endif
+            return 1;
+        }
+    }
+    if (!crn_spec.empty())
+    {
+        if      (crn_spec == "iteration") crn_mode = CRN_ITERATION;
+        else if (crn_spec == "run")       crn_mode = CRN_RUN;
+        else if (crn_spec == "off")       crn_mode = CRN_OFF;
+        else
+        {
+            if (id == 0) cout << " Common random numbers   : unknown mode " << crn_spec << " (iteration | run | off)" << endl;
+#ifdef USE_MPI
+            ierr = MPI_Finalize();
+#endif
+            return 1;
+        }
+    }
+    {
+        string error;
+        if (!optimizer_name.empty() && !parse_Opt_Method(optimizer_name.c_str(), optimizer)) error = "unknown optimizer " + optimizer_name;
+        if (error.empty() && !fit_spec.empty()) parse_Fit(fit_spec, error);
+        if (!error.empty())
+        {
+            if (id == 0) cout << " Optimizer               : " << error << endl;
+#ifdef USE_MPI
+            ierr = MPI_Finalize();
+#endif
+            return 1;
+        }
+    }
+    // the swarm below fits the four rates of swarm_Rate; everything else goes to optimizer.h
+    const bool swarm_fit = optimizer == OPT_PSO && n_fit == 4 && memcmp(fit_rate, swarm_Rate, sizeof(swarm_Rate)) == 0;
+    bool swarm_options = false; // options of the swarm given to another optimizer
+    if (!swarm_fit && (!resume_file.empty() || !checkpoint_file.empty() || async_pso || fidelity.n_levels > 0 || !telemetry_file.empty() || use_surrogate))
+    {
+        use_surrogate = false;
+        resume_file.clear();
+        checkpoint_file.clear();
+        telemetry_file.clear();
+        async_pso         = false;
+        fidelity.n_levels = 0;
+        swarm_options     = true;
+    }
+#ifdef USE_MPI
+    ierr = MPI_Bcast(&run_seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+#endif
+    //---------------------------------------------------------------------------------
+    // Experimental data: parsed once on rank 0, the other ranks get a copy of the block
+    //---------------------------------------------------------------------------------
+    int data_ok = 1;
+    if (id == 0)
+    {
+        string error;
+        exp_Clear(exp_data);
+        if (!load_Dataset(exp_data, ca_data_file.c_str(), DATA_CALCIUM, ca_weight, 0.0f, error) ||
+            (!pi_data_file.empty() && !load_Dataset(exp_data, pi_data_file.c_str(), DATA_PHOSPHATE, pi_weight, pi_Ca_cyt, error)))
+        {
+            cout << " Experimental data       : " << error << endl;
+            data_ok = 0;
+        }
+    }
+#ifdef USE_MPI
+    ierr = MPI_Bcast(&data_ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    ierr = MPI_Bcast(&exp_data, sizeof(exp_data), MPI_BYTE, 0, MPI_COMM_WORLD);
+#endif
+    if (!data_ok)
+    {
+#ifdef USE_MPI
+        ierr = MPI_Finalize();
+#endif
+        return 1;
+    }
+    //---------------------------------------------------------------------------------
+    // --resume: the swarm of an earlier run (same settings) instead of a new one
+    //---------------------------------------------------------------------------------
+    static swarm_State resume_state;
+    const bool resumed = !resume_file.empty();
+    if (resumed)
+    {
+        int resume_ok = 1;
+        if (id == 0)
+        {
+            string error;
+            static swarm_State key;
+            if (read_Checkpoint(resume_file.c_str(), &resume_state, sizeof(resume_state), error))
+            {
+                run_seed = resume_state.seed;
+                swarm_Key(key);
+                if (memcmp(&key, &resume_state, offsetof(swarm_State, next_iter)) != 0) error = resume_file + " was written with other run settings";
+            }
+            if (!error.empty())
+            {
+                cout << " Resume                  : " << error << endl;
+                resume_ok = 0;
+            }
+        }
+#ifdef USE_MPI
+        ierr = MPI_Bcast(&resume_ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        ierr = MPI_Bcast(&resume_state, sizeof(resume_state), MPI_BYTE, 0, MPI_COMM_WORLD);
+        ierr = MPI_Bcast(&run_seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+#endif
+        if (!resume_ok)
+        {
+#ifdef USE_MPI
+            ierr = MPI_Finalize();
+#endif
+            return 1;
+        }
+        if (checkpoint_file.empty()) checkpoint_file = resume_file;
+    }
+    if (id == 0) cout << " Random seed of this run : " << run_seed << endl;
+    if (id == 0) cout << " SERCA molecules stepped : " << simd_Level_Name(simd_level) << endl;
+    if (id == 0) cout << " Simulation engine       : " << sim_Engine_Name(sim_engine) << " (last run: " << sim_Engine_Name(last_engine) << ")" << endl;
+    if (id == 0 && (sim_engine == ENGINE_GPU || last_engine == ENGINE_GPU))
+    {
+        cout << " GPU                     : " << (gpu_Available() ? gpu_Device_Name() : "none, fixed-dt on the CPU") << endl;
+    }
+    if (id == 0) cout << " Steady-state window     : steps " << fit_config.window.begin << " - " << fit_config.window.end
+                      << ", sampled every " << fit_config.window.stride << " (last run: " << last_config.window.stride << ")" << endl;
+    if (id == 0 && ss_detect) cout << " Steady-state detection  : blocks of " << fit_config.window.block << " samples, drift < "
+                                   << 100 * fit_config.window.drift_tol << " %, " << fit_config.window.n_eff << " effective samples per molecule" << endl;
+    for (int d = 0; d < exp_data.n_datasets && id == 0; d++)
+    {
+        if (exp_data.n_datasets == 1 && exp_data.set[d].weight == 1.0f) break; // the usual single pCa curve
+        cout << " Experimental data       : " << exp_data.set[d].file << " (" << data_Kind_Name(exp_data.set[d].kind) << ", "
+             << exp_data.set[d].n_points << " points, weight " << exp_data.set[d].weight << ")" << endl;
+    }
+    if (id == 0 && model.topology != TOPOLOGY_INESI) cout << " Model topology          : " << topology_Name(model.topology) << endl;
+    if (async_pso && (p > 1 || resumed || !checkpoint_file.empty()))
+    {
+        if (id == 0) cout << " Asynchronous swarm      : needs one MPI rank and no checkpoint, iterating synchronously" << endl;
+        async_pso = false;
+    }
+    if (async_pso && fidelity.n_levels > 1)
+    {
+        if (id == 0) cout << " Fidelity schedule       : needs the synchronous swarm, full fidelity throughout" << endl;
+        fidelity.n_levels = 0;
+    }
+    if (use_surrogate && async_pso)
+    {
+        if (id == 0) cout << " Surrogate               : needs the synchronous swarm, every move simulated" << endl;
+        use_surrogate = false;
+    }
+    if (use_surrogate)
+    {
+        const float lower[4] = { k_S0_S1_lower, k_S2_S3_lower, k_S7_S8_lower, k_S9_S10_lower };
+        const float upper[4] = { k_S0_S1_upper, k_S2_S3_upper, k_S7_S8_upper, k_S9_S10_upper };
+        surrogate_Init(surrogate, 4, lower, upper, surrogate_neighbours, surrogate_kappa);
+        if (id == 0) cout << " Surrogate               : local GP on " << surrogate.n_neighbours << " neighbours, simulate if mean - "
+                          << surrogate.kappa << " sigma <= pbest" << (resumed ? " (archive not in the checkpoint, starts empty)" : "") << endl;
+    }
+    if (id == 0 && fidelity.n_levels > 1)
+    {
+        cout << " Fidelity schedule       : ";
+        for (int l = 0; l < fidelity.n_levels; l++) cout << (l > 0 ? " -> " : "") << fidelity_Name(fidelity.level[l]);
+        cout << endl;
+    }
+    cache_Init(residual_cache, cache_resolution, cache_max > 0 ? cache_max : 0);
+    if (id == 0 && residual_cache.enabled) cout << " Residual cache          : bins of " << cache_resolution << " in log10 k, up to "
+                                                << residual_cache.max_entries << " entries" << endl;
+    if (id == 0 && crn_mode != CRN_OFF) cout << " Common random numbers   : same streams for every particle of "
+                                             << (crn_mode == CRN_RUN ? "the run" : "an iteration") << endl;
+    if (id == 0 && async_pso) cout << " Asynchronous swarm      : work queue of " << (max_iter+1) * n_particles_PSO << " evaluations" << endl;
+    if (id == 0 && fused_pCa) cout << " pCa curve               : " << (ss_detect ? "not fused, every point detects its own window"
+                                                                             : "fused (common random numbers across pCa)") << endl;
+    if (id == 0 && adaptive.enabled) cout << " Adaptive molecule count : batches of " << adaptive.batch << ", z = " << adaptive.z
+                                          << ", rel. tolerance = " << adaptive.rel_tol << endl;
+    if (id == 0 && !swarm_fit)
+    {
+        cout << " Optimizer               : " << opt_Method_Name(optimizer) << " on";
+        for (int k = 0; k < n_fit; k++) cout << " " << rate_Name(fit_rate[k]);
+        cout << ", " << (max_iter + 2) * n_particles_PSO << " residual evaluations" << endl;
+        if (swarm_options) cout << " Optimizer               : --checkpoint, --resume, --async, --fidelity, --telemetry and --surrogate need the swarm, ignored" << endl;
+    }
+    if (id == 0 && polish_evals > 0) cout << " Nelder-Mead polish      : up to " << polish_evals << " evaluations, all on one stream" << endl;
+    if (id == 0 && !trajectory_file.empty())
+    {
+        if (last_engine == ENGINE_FIXED_DT || last_engine == ENGINE_GPU)
+        {
+            cout << " Trajectory              : " << trajectory_file << ", every " << trajectory_stride << " steps of the last run" << endl;
+        }
+        else
+        {
+            cout << " Trajectory              : needs the fixed-dt last engine, not written" << endl;
+        }
+    }
+    if (id == 0 && !telemetry_file.empty())
+    {
+        const char *rate_names[telemetry_Rates];
+        for (int k = 0; k < telemetry_Rates; k++) rate_names[k] = rate_Name(swarm_Rate[k]);
+        if (telemetry_Open(telemetry, telemetry_file.c_str(), rate_names, telemetry_flush))
+        {
+            cout << " Telemetry               : " << telemetry_file << ", written every " << telemetry_flush << " s" << endl;
+        }
+        else
+        {
+            cout << " Telemetry               : cannot open " << telemetry_file << endl;
+        }
+    }
+    if (!swarm_fit)
+    {
+        run_Optimizer(startTime, trajectory_file.empty() ? NULL : trajectory_file.c_str(), trajectory_stride);
+#ifdef USE_MPI
+        ierr = MPI_Finalize();
+#endif
+        return 0;
+    }
+    srand(run_seed); // PSO positions and velocities (drawn on rank 0)
+    float Res_gbest;
+    int   first_iter = 0;
+    if (resumed)
+    {
+        restore_Swarm(resume_state, Res_gbest);
+        first_iter = resume_state.next_iter;
+        // the level the saved pbest residuals were computed at
+        set_Fidelity(fidelity_At(first_iter-1));
+        if (id == 0) cout << " Resumed from            : " << resume_file << ", swarm iteration " << first_iter << endl;
+    }
+    else
+    {
     //------------------------------------------------------------------------------------------//
     //                                                                                          //
     //                                                                                          //
@@ -193,123 +1349,110 @@ int main(int argc, char *argv[])
     //------------------------------------------------------------------------------------------//
   
   
-    //----------------------------------------------
-    // Step 1: construct particle-parameter arrays
-    //          Particles positions and velocities
-    //----------------------------------------------
+        //----------------------------------------------
+        // Step 1: construct particle-parameter arrays
+        //          Particles positions and velocities
+        //----------------------------------------------
     
-    for (int i = 0; i < n_particles_PSO; i++)
-    {
-        //-----------
-        // positions
-        //-----------
-        cout << " Particle " << i+1 << " initialized. " << std::endl;
-        //X_Ca_cyt_conc_PSO[i] = Ca_cyt_conc_lower  + (Ca_cyt_conc_upper - Ca_cyt_conc_lower) * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-	X_k_S0_S1_PSO    [i] = k_S0_S1_lower      + (k_S0_S1_upper    - k_S0_S1_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);   //original Inesi value 4e7
-        X_k_S2_S3_PSO    [i] = k_S2_S3_lower      + (k_S2_S3_upper    - k_S2_S3_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);   //original Inesi value 1e8
-        X_k_S7_S8_PSO    [i] = k_S7_S8_lower      + (k_S7_S8_upper    - k_S7_S8_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);   //original Inesi value 500
-        X_k_S9_S10_PSO  [i] = k_S9_S10_lower    + (k_S9_S10_upper  - k_S9_S10_lower)   * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);    //original Inesi value 6e2
+        for (int i = 0; i < n_particles_PSO; i++)
+        {
+            //-----------
+            // positions
+            //-----------
+            if (id == 0 && verbosity >= 1) cout << " Particle " << i+1 << " initialized. " << '\n';
+            //X_Ca_cyt_conc_PSO[i] = Ca_cyt_conc_lower  + (Ca_cyt_conc_upper - Ca_cyt_conc_lower) * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+    	X_k_S0_S1_PSO    [i] = k_S0_S1_lower      + (k_S0_S1_upper    - k_S0_S1_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);   //original Inesi value 4e7
+            X_k_S2_S3_PSO    [i] = k_S2_S3_lower      + (k_S2_S3_upper    - k_S2_S3_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);   //original Inesi value 1e8
+            X_k_S7_S8_PSO    [i] = k_S7_S8_lower      + (k_S7_S8_upper    - k_S7_S8_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);   //original Inesi value 500
+            X_k_S9_S10_PSO  [i] = k_S9_S10_lower    + (k_S9_S10_upper  - k_S9_S10_lower)   * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);    //original Inesi value 6e2
     
-//        X_k_S5_S6a_PSO_local    [i] = k_S5_S6a_lower      + (k_S5_S6a_upper    - k_S5_S6a_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-//        X_k_S6_S7_PSO_local    [i] = k_S6_S7_lower      + (k_S6_S7_upper    - k_S6_S7_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-//        X_k_S0_S11_PSO_local   [i] = k_S0_S11_lower     + (k_S0_S11_upper   - k_S0_S11_lower)    * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+    //        X_k_S5_S6a_PSO_local    [i] = k_S5_S6a_lower      + (k_S5_S6a_upper    - k_S5_S6a_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+    //        X_k_S6_S7_PSO_local    [i] = k_S6_S7_lower      + (k_S6_S7_upper    - k_S6_S7_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+    //        X_k_S0_S11_PSO_local   [i] = k_S0_S11_lower     + (k_S0_S11_upper   - k_S0_S11_lower)    * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
 
 
 
-        //------------------------------------------------------------------
-        // Velocities : 0.25*(lower-upper)*rand : this is can be anything
-        //--------------------------------------------------------------------
-        //V_Ca_cyt_conc_PSO [i] = 0.25* (Ca_cyt_conc_upper - Ca_cyt_conc_lower) * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        V_k_S0_S1_PSO     [i] = 0.25* (k_S0_S1_upper    - k_S0_S1_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        V_k_S2_S3_PSO     [i] = 0.25* (k_S2_S3_upper    - k_S2_S3_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        V_k_S7_S8_PSO     [i] = 0.25* (k_S7_S8_upper    - k_S7_S8_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        V_k_S9_S10_PSO   [i] = 0.25* (k_S9_S10_upper  - k_S9_S10_lower)   * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-//        V_k_S5_S6a_PSO     [i] = 0.25* (k_S5_S6a_upper    - k_S5_S6a_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-//        V_k_S6_S7_PSO     [i] = 0.25* (k_S6_S7_upper    - k_S6_S7_lower)     * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-//        V_k_S0_S11_PSO    [i] = 0.25* (k_S0_S11_upper   - k_S0_S11_lower)    * static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-    }
+            //------------------------------------------------------------------
+            // Velocities : 0.25*(lower-upper)*rand : this is can be anything
+            //--------------------------------------------------------------------
+            //V_Ca_cyt_conc_PSO [i] = 0.25* (Ca_cyt_conc_upper - Ca_cyt_conc_lower) * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+            V_k_S0_S1_PSO     [i] = 0.25* (k_S0_S1_upper    - k_S0_S1_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+            V_k_S2_S3_PSO     [i] = 0.25* (k_S2_S3_upper    - k_S2_S3_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+            V_k_S7_S8_PSO     [i] = 0.25* (k_S7_S8_upper    - k_S7_S8_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+            V_k_S9_S10_PSO   [i] = 0.25* (k_S9_S10_upper  - k_S9_S10_lower)   * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+    //        V_k_S5_S6a_PSO     [i] = 0.25* (k_S5_S6a_upper    - k_S5_S6a_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+    //        V_k_S6_S7_PSO     [i] = 0.25* (k_S6_S7_upper    - k_S6_S7_lower)     * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+    //        V_k_S0_S11_PSO    [i] = 0.25* (k_S0_S11_upper   - k_S0_S11_lower)    * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX);
+        }
     
-    //--------------------------------------------------------------------------
-    // Step 2: solve for each particle-parameter sets to obtain residual array
-    //---------------------------------------------------------------------------
-  
-    for (int i = 0; i < n_particles_PSO; i++)
-    {
-        //Ca_cyt_conc = X_Ca_cyt_conc_PSO[i];
-        k_S0_S1    = X_k_S0_S1_PSO[i];
-        k_S2_S3    = X_k_S2_S3_PSO[i];
-        k_S7_S8    = X_k_S7_S8_PSO[i];
-        k_S9_S10  = X_k_S9_S10_PSO[i];
-//        k_S5_S6a    = X_k_S5_S6a_PSO_local[i];
-//        k_S6_S7    = X_k_S6_S7_PSO_local[i];
-//        k_S0_S11   = X_k_S0_S11_PSO_local[i];
-        //-----------------------------------------------------------------------------------------
-        // Call the force_pCa_curve function to get the force as a function of Ca++ concentrations.
-        // NB: this function implicitly calls the other functions.
-        //-----------------------------------------------------------------------------------------
-        
-        residual_cost_func[i] = get_Residual  (n_SERCA_Molecules,
-                                               max_tsteps,
-                                               dt,
-                                               n_s,
-                                               n_pCa,
-                                               k_S0_S1,
-                                               k_S2_S3,
-                                               k_S7_S8,
-                                               k_S9_S10, k_S1_S0, k_S1_S2,  k_S2_S1, k_S3_S2, k_S3_S4,  k_S4_S3, k_S4_S5, k_S5_S4, k_S5_S6a,  k_S6a_S5, k_S6a_S7, k_S7_S6a, k_S5_S6,  k_S6_S5, k_S6_S7, k_S7_S6,  k_S8_S7, k_S8_S9, k_S9_S8,k_S10_S9, k_S10_S11,k_S11_S10,k_S11_S0,k_S0_S11, Ca_sr_conc, MgATP_conc, MgADP_conc, Pi_conc
-                                               );
-      
-        cout << " Particle # " << i+1 << endl;
-        cout << " k_S0_S1 = " << k_S0_S1 << ", k_S2_S3 = " << k_S2_S3 << ", k_S7_S8 = " << k_S7_S8 << ", k_S9_S10 = " << k_S9_S10 << endl;
-        cout << " Residual =  " << residual_cost_func[i] << endl;  //**
+        //--------------------------------------------------------------------------
+        // Step 2: solve for each particle-parameter sets to obtain residual array
+        //---------------------------------------------------------------------------
+        set_Fidelity(fidelity_At(-1));
+        broadcast_Positions();
+        evaluate_Particles(0, false);
+        learn_Particles(swarm_X, NULL);
+        log_Particles(-1);
+
+        for (int i = 0; i < n_particles_PSO && id == 0 && verbosity >= 1; i++)
+        {
+            cout << " Particle # " << i+1 << '\n';
+            cout << " k_S0_S1 = " << X_k_S0_S1_PSO[i] << ", k_S2_S3 = " << X_k_S2_S3_PSO[i] << ", k_S7_S8 = " << X_k_S7_S8_PSO[i] << ", k_S9_S10 = " << X_k_S9_S10_PSO[i] << '\n';
+            cout << " Residual =  " << residual_cost_func[i] << '\n';  //**
 
-    } // close loop of particle
-     cout << "One iteration runtime: " << (time(NULL)-startTime) << " second(s)" << std::endl;
+        } // close loop of particle
+        if (id == 0) cout << "One iteration runtime: " << (time(NULL)-startTime) << " second(s)" << std::endl;
   
   
-    //------------------------------------------
-    // Find Min of Residual (i.e., global best)
-    //------------------------------------------
-    float Res_gbest = residual_cost_func [0];
-    int i_Res_gbest = 0;
-    for (int i = 0; i < n_particles_PSO; i++)
-    {
-        if (residual_cost_func [i] < Res_gbest)
+        //------------------------------------------
+        // Find Min of Residual (i.e., global best)
+        //------------------------------------------
+        Res_gbest = residual_cost_func [0];
+        int i_Res_gbest = 0;
+        for (int i = 0; i < n_particles_PSO; i++)
         {
-            Res_gbest    = residual_cost_func [i];
-            i_Res_gbest  = i;
+            if (residual_cost_func [i] < Res_gbest)
+            {
+                Res_gbest    = residual_cost_func [i];
+                i_Res_gbest  = i;
 
-        }
+            }
         
-        Res_pbest[i] = residual_cost_func [i];  // Residual personal best
-    }
+            Res_pbest[i] = residual_cost_func [i];  // Residual personal best
+        }
     
-    //--------------------------------------------------------
-    // obtain the parameters that give global (gbest)
-    //--------------------------------------------------------
-    //Ca_cyt_conc_gbest = X_Ca_cyt_conc_PSO[i_Res_gbest];
-    k_S0_S1_gbest     = X_k_S0_S1_PSO[i_Res_gbest];
-    k_S2_S3_gbest     = X_k_S2_S3_PSO[i_Res_gbest];
-    k_S7_S8_gbest     = X_k_S7_S8_PSO[i_Res_gbest];
-    k_S9_S10_gbest   = X_k_S9_S10_PSO[i_Res_gbest];
-//    k_S6_S7_gbest     = X_k_S6_S7_PSO[i_Res_gbest];
-//    k_S0_S11_gbest    = X_k_S0_S11_PSO[i_Res_gbest];
-    //---------------------------------------------------------------------------------------
-    // obtain the parameters that give personal best (pbest)
-    // Note: this can be combined with one of the other loop but keep it like that for now
-    //----------------------------------------------------------------------------------------
+        //--------------------------------------------------------
+        // obtain the parameters that give global (gbest)
+        //--------------------------------------------------------
+        //Ca_cyt_conc_gbest = X_Ca_cyt_conc_PSO[i_Res_gbest];
+        k_S0_S1_gbest     = X_k_S0_S1_PSO[i_Res_gbest];
+        k_S2_S3_gbest     = X_k_S2_S3_PSO[i_Res_gbest];
+        k_S7_S8_gbest     = X_k_S7_S8_PSO[i_Res_gbest];
+        k_S9_S10_gbest   = X_k_S9_S10_PSO[i_Res_gbest];
+    //    k_S6_S7_gbest     = X_k_S6_S7_PSO[i_Res_gbest];
+    //    k_S0_S11_gbest    = X_k_S0_S11_PSO[i_Res_gbest];
+        //---------------------------------------------------------------------------------------
+        // obtain the parameters that give personal best (pbest)
+        // Note: this can be combined with one of the other loop but keep it like that for now
+        //----------------------------------------------------------------------------------------
     
-    for (int i = 0; i < n_particles_PSO; i++)
-    {
-        //Ca_cyt_conc_pbest[i] = X_Ca_cyt_conc_PSO[i];
-        k_S0_S1_pbest[i]     = X_k_S0_S1_PSO[i];
-        k_S2_S3_pbest[i]     = X_k_S2_S3_PSO[i];
-        k_S7_S8_pbest[i]     = X_k_S7_S8_PSO[i];
-        k_S9_S10_pbest[i]   = X_k_S9_S10_PSO[i];
-//        k_S5_S6a_pbest[i]     = X_k_S5_S6a_PSO[i];
-//        k_S6_S7_pbest[i]     = X_k_S6_S7_PSO[i];
-//        k_S0_S11_pbest[i]    = X_k_S0_S11_PSO[i];
-    }
+        for (int i = 0; i < n_particles_PSO; i++)
+        {
+            //Ca_cyt_conc_pbest[i] = X_Ca_cyt_conc_PSO[i];
+            k_S0_S1_pbest[i]     = X_k_S0_S1_PSO[i];
+            k_S2_S3_pbest[i]     = X_k_S2_S3_PSO[i];
+            k_S7_S8_pbest[i]     = X_k_S7_S8_PSO[i];
+            k_S9_S10_pbest[i]   = X_k_S9_S10_PSO[i];
+    //        k_S5_S6a_pbest[i]     = X_k_S5_S6a_PSO[i];
+    //        k_S6_S7_pbest[i]     = X_k_S6_S7_PSO[i];
+    //        k_S0_S11_pbest[i]    = X_k_S0_S11_PSO[i];
+        }
+    
+        if (!checkpoint_file.empty() && id == 0 && !save_Swarm(checkpoint_file.c_str(), 0, Res_gbest))
+        {
+            cout << " Checkpoint              : cannot write " << checkpoint_file << endl;
+        }
+    } // end new swarm
     
     //----------------------------------------------------------------------------------
     //
@@ -318,9 +1461,11 @@ int main(int argc, char *argv[])
     //
     //
     //------------------ --------------------------------------------------------------
-    const int max_iter = 100;
-    float total_gbest[max_iter]; ; 
-if (max_iter != 0)
+if (async_pso)
+{
+    run_Async_Swarm(Res_gbest);
+}
+else if (max_iter != 0)
 {     
 float w_max, w_min, dw, w;
     float c1, c2;
@@ -329,32 +1474,34 @@ float w_max, w_min, dw, w;
     dw = (w_max-w_min)/max_iter;
     c1 = 1.05;
     c2 = 1.05;
-    for (int it = 0; it < max_iter+1; it++)
+    for (int it = first_iter; it < max_iter+1; it++)
     { // begin swarm iteration
         w = w_min +it*dw;
-        for (int i = 0; i < n_particles_PSO; i++)
-        { // begin loop over all particles
+        int level = fidelity_At(it);
+        if (level != fidelity_level) raise_Fidelity(level, Res_gbest);
+        for (int i = 0; i < n_particles_PSO && id == 0; i++)
+        { // begin loop over all particles (the PSO random numbers are drawn on rank 0 only)
             
             //-----------------
             // Velocity update
             //-----------------
             
-            //V_Ca_cyt_conc_PSO[i] = w  * V_Ca_cyt_conc_PSO [i] + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (Ca_cyt_conc_pbest[i]   - X_Ca_cyt_conc_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (Ca_cyt_conc_gbest - X_Ca_cyt_conc_PSO[i]) ;
+            //V_Ca_cyt_conc_PSO[i] = w  * V_Ca_cyt_conc_PSO [i] + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (Ca_cyt_conc_pbest[i]   - X_Ca_cyt_conc_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (Ca_cyt_conc_gbest - X_Ca_cyt_conc_PSO[i]) ;
             
             
-            V_k_S0_S1_PSO[i]    = w  * V_k_S0_S1_PSO [i]      + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S0_S1_pbest[i]   - X_k_S0_S1_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S0_S1_gbest      - X_k_S0_S1_PSO[i]) ;
+            V_k_S0_S1_PSO[i]    = w  * V_k_S0_S1_PSO [i]      + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S0_S1_pbest[i]   - X_k_S0_S1_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S0_S1_gbest      - X_k_S0_S1_PSO[i]) ;
             
-            V_k_S2_S3_PSO[i]    = w  * V_k_S2_S3_PSO [i]      + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S2_S3_pbest[i]   - X_k_S2_S3_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S2_S3_gbest      - X_k_S2_S3_PSO[i]) ;
+            V_k_S2_S3_PSO[i]    = w  * V_k_S2_S3_PSO [i]      + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S2_S3_pbest[i]   - X_k_S2_S3_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S2_S3_gbest      - X_k_S2_S3_PSO[i]) ;
             
-            V_k_S7_S8_PSO[i]    = w  * V_k_S7_S8_PSO [i]      + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S7_S8_pbest[i]   - X_k_S7_S8_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S7_S8_gbest      - X_k_S7_S8_PSO[i]) ;
+            V_k_S7_S8_PSO[i]    = w  * V_k_S7_S8_PSO [i]      + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S7_S8_pbest[i]   - X_k_S7_S8_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S7_S8_gbest      - X_k_S7_S8_PSO[i]) ;
             
-            V_k_S9_S10_PSO[i]  = w  * V_k_S9_S10_PSO [i]    + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S9_S10_pbest[i]   - X_k_S9_S10_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S9_S10_gbest      - X_k_S9_S10_PSO[i]) ;
+            V_k_S9_S10_PSO[i]  = w  * V_k_S9_S10_PSO [i]    + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S9_S10_pbest[i]   - X_k_S9_S10_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S9_S10_gbest      - X_k_S9_S10_PSO[i]) ;
 
-//            V_k_S5_S6a_PSO[i]  = w  * V_k_S5_S6a_PSO [i]    + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S5_S6a_pbest[i]   - X_k_S5_S6a_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S5_S6a_gbest      - X_k_S5_S6a_PSO[i]) ;
+//            V_k_S5_S6a_PSO[i]  = w  * V_k_S5_S6a_PSO [i]    + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S5_S6a_pbest[i]   - X_k_S5_S6a_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S5_S6a_gbest      - X_k_S5_S6a_PSO[i]) ;
 
-//            V_k_S6_S7_PSO[i]  = w  * V_k_S6_S7_PSO [i]    + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S6_S7_pbest[i]   - X_k_S6_S7_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S6_S7_gbest      - X_k_S6_S7_PSO[i]) ;
+//            V_k_S6_S7_PSO[i]  = w  * V_k_S6_S7_PSO [i]    + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S6_S7_pbest[i]   - X_k_S6_S7_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S6_S7_gbest      - X_k_S6_S7_PSO[i]) ;
 
-//            V_k_S0_S11_PSO[i]  = w  * V_k_S0_S11_PSO [i]    + c1 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S0_S11_pbest[i]   - X_k_S0_S11_PSO[i]) + c2 * static_cast <float> (rand()) / static_cast <float> (RAND_MAX) * (k_S0_S11_gbest      - X_k_S0_S11_PSO[i]) ;
+//            V_k_S0_S11_PSO[i]  = w  * V_k_S0_S11_PSO [i]    + c1 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S0_S11_pbest[i]   - X_k_S0_S11_PSO[i]) + c2 * static_cast <float> (pso_Rand()) / static_cast <float> (RAND_MAX) * (k_S0_S11_gbest      - X_k_S0_S11_PSO[i]) ;
             
             //-----------------
             // position update
@@ -367,34 +1514,22 @@ float w_max, w_min, dw, w;
             //X_k_S5_S6a_PSO_local[i]     = X_k_S5_S6a_PSO[i]     + V_k_S5_S6a_PSO[i];
  			      //X_k_S6_S7_PSO_local[i]     = X_k_S6_S7_PSO[i]     + V_k_S6_S7_PSO[i];
  			      //X_k_S0_S11_PSO_local[i]    = X_k_S0_S11_PSO[i]    + V_k_S0_S11_PSO[i];
-            //---------------------------
-            // model parameter update
-            //---------------------------
-            //Ca_cyt_conc = X_Ca_cyt_conc_PSO[i];
-            k_S0_S1     = X_k_S0_S1_PSO[i];
-            k_S2_S3     = X_k_S2_S3_PSO[i];
-            k_S7_S8     = X_k_S7_S8_PSO[i];
-            k_S9_S10   = X_k_S9_S10_PSO[i];
-            //k_S5_S6a     = X_k_S5_S6a_PSO_local[i];
-            //k_S6_S7     = X_k_S6_S7_PSO_local[i];
-            //k_S0_S11    = X_k_S0_S11_PSO_local[i]; 
-            //-----------------------------------------------------
-            // residual update using the new particles/parameters
-            //----------------------------------------------------
-            residual_cost_func[i] = get_Residual  (n_SERCA_Molecules,
-                                                   max_tsteps,
-                                                   dt,
-                                                   n_s,
-                                                   n_pCa,
-                                                   k_S0_S1,
-                                                   k_S2_S3,
-                                                   k_S7_S8,
-                                                   k_S9_S10, k_S1_S0, k_S1_S2,  k_S2_S1, k_S3_S2, k_S3_S4, k_S4_S3, k_S4_S5, k_S5_S4, k_S5_S6a,  k_S6a_S5, k_S6a_S7, k_S7_S6a, k_S5_S6,  k_S6_S5, k_S6_S7, k_S7_S6,  k_S8_S7, k_S8_S9, k_S9_S8,k_S10_S9, k_S10_S11,k_S11_S10,k_S11_S0,k_S0_S11, Ca_sr_conc, MgATP_conc, MgADP_conc, Pi_conc
-                                                   );
+        }// end looping over all particles to have new positions
+
+        //-----------------------------------------------------
+        // residual update using the new particles/parameters
+        //----------------------------------------------------
+        broadcast_Positions();
+        screen_Particles();
+        evaluate_Particles((it+1)*n_particles_PSO, true, swarm_X, screened);
+        learn_Particles(swarm_X, screened);
+        log_Particles(it);
 
-        cout << " Particle # " << i+1 << endl;
-        cout << "        k_S0_S1 = " << k_S0_S1 << ", k_S2_S3 = " << k_S2_S3 << ", k_S7_S8 = " << k_S7_S8 << ", k_S9_S10 = " << k_S9_S10 << endl;
-        cout << " Residual =  " << residual_cost_func[i];            
+        for (int i = 0; i < n_particles_PSO && id == 0 && verbosity >= 1; i++)
+        {
+            cout << " Particle # " << i+1 << '\n';
+            cout << "        k_S0_S1 = " << X_k_S0_S1_PSO[i] << ", k_S2_S3 = " << X_k_S2_S3_PSO[i] << ", k_S7_S8 = " << X_k_S7_S8_PSO[i] << ", k_S9_S10 = " << X_k_S9_S10_PSO[i] << '\n';
+            cout << " Residual =  " << residual_cost_func[i];
         }// end looping over all particles to have new Residual vector
         
       
@@ -412,7 +1547,7 @@ float w_max, w_min, dw, w;
                  
 	    }
 	    
-            cout << " New Residuals         = " << residual_cost_func [i] << endl;
+            if (id == 0 && verbosity >= 1) cout << " New Residuals         = " << residual_cost_func [i] << '\n';
         }
   
         
@@ -436,25 +1571,7 @@ float w_max, w_min, dw, w;
         }
 
         total_gbest [it] = Res_gbest;
-	cout << " " << endl;
-	cout << "The total global best is now : " << total_gbest [it]<< endl;
-	cout << " " << endl;
-        
-
-       // write iteration vs. gbest in a file
-       std::string outfilename = "iterations_vs_global_best.csv";
-    
-       ofstream iter_out(outfilename.c_str()); //opening an output stream for file test.txt
-    		if(iter_out.is_open()) //checking whether file could be opened or not.
-    		{
-        		// create headers for file
-        		iter_out << "iteration  vs  gbest" << endl; // write the average force
-        		for (int g = 0; g < max_iter; g++)  // time marching
-        		{
-                        iter_out << g << "  " << total_gbest[g]  << endl; // write the average force
-        		}
-        		cout << "Iterations and Global best successfully saved into the file " << outfilename << endl;
-        	}
+        if (id == 0) write_Gbest_History(it);
 
 
         for (int i = 0; i < n_particles_PSO; i++)
@@ -476,9 +1593,25 @@ float w_max, w_min, dw, w;
             }
         }
         
+        if (!checkpoint_file.empty() && id == 0 && !save_Swarm(checkpoint_file.c_str(), it+1, Res_gbest))
+        {
+            cout << " Checkpoint              : cannot write " << checkpoint_file << endl;
+        }
+        
         
     }}// end swarm iteration
+
+    if (polish_evals > 0)
+    {
+        serca_Model polished = model;
+        for (int k = 0; k < 4; k++) polished.rates[swarm_Rate[k]] = *swarm_gbest[k];
+        Res_gbest = polish_Rates(polished, (long long)(max_iter + 2 + max_Fidelity_Levels) * n_particles_PSO);
+        for (int k = 0; k < 4; k++) *swarm_gbest[k] = polished.rates[swarm_Rate[k]];
+    }
   
+    telemetry_Close(telemetry);
+    if (id == 0)
+    {
     cout << "\"Res_gbest\","       << Res_gbest  <<  endl;
     cout << "\"k_S0_S1_gbest  \","  << k_S0_S1_gbest   << " original Inesi value 4e+07" << endl;
     cout << "\"k_S2_S3_gbest  \","  << k_S2_S3_gbest   << " original Inesi value 1e+08" << endl;
@@ -491,15 +1624,17 @@ float w_max, w_min, dw, w;
     
 
 
-    lastRun(n_SERCA_Molecules,
-    		max_tsteps,
-    		dt,
-    		n_s,
-    		n_pCa,
-    		k_S0_S1_gbest,
-    		k_S2_S3_gbest,
-    		k_S7_S8_gbest,
-    		k_S9_S10_gbest, k_S1_S0, k_S1_S2,  k_S2_S1, k_S3_S2, k_S3_S4,  k_S4_S3, k_S4_S5, k_S5_S4, k_S5_S6a, k_S6a_S5, k_S6a_S7, k_S7_S6a, k_S5_S6,  k_S6_S5, k_S6_S7, k_S7_S6,  k_S8_S7, k_S8_S9, k_S9_S8,k_S10_S9, k_S10_S11, k_S11_S10, k_S11_S0, k_S0_S11, Ca_sr_conc, MgATP_conc, MgADP_conc, Pi_conc);
+    serca_Model best = model;
+    best.rates[K_S0_S1]  = k_S0_S1_gbest;
+    best.rates[K_S2_S3]  = k_S2_S3_gbest;
+    best.rates[K_S7_S8]  = k_S7_S8_gbest;
+    best.rates[K_S9_S10] = k_S9_S10_gbest;
+    lastRun(best, last_config, exp_data, run_seed, trajectory_file.empty() ? NULL : trajectory_file.c_str(), trajectory_stride);
+    }
+
+#ifdef USE_MPI
+    ierr = MPI_Finalize();
+#endif
     
     return 0;
 } // end main function
@@ -0,0 +1,452 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// PSO, CMA-ES and Nelder-Mead over the log10 rates (see optimizer.h).
+//
+// All three work in the coordinates u = (x - lower) / (upper - lower) of the box. The box only sets where
+// they start and the scale of their first steps: as the swarm of main.cpp, which only places its
+// particles inside the bounds, they may leave it (in log space the rates stay positive).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <algorithm> // min / max
+#include "rng_Philox.h"
+#include "optimizer.h"
+
+using namespace std;
+
+// bookkeeping of one optimizer run
+struct opt_Run
+{
+    const opt_Problem   *problem;
+    opt_Result          *result;
+    philox_Stream        rng;
+    bool                 one_stream; // Nelder-Mead: every evaluation on the same stream
+    unsigned int         stream;     // ... this one
+    vector<double>       x;          // the batch in log10 k
+    vector<unsigned int> streams;
+};
+
+bool parse_Opt_Method(const char *name, opt_Method &method)
+{
+    if (strcmp(name, "pso")   == 0) { method = OPT_PSO;   return true; }
+    if (strcmp(name, "cmaes") == 0) { method = OPT_CMAES; return true; }
+    return false;
+}
+
+const char *opt_Method_Name(opt_Method method)
+{
+    return (method == OPT_CMAES) ? "cmaes" : "pso";
+}
+
+static void start_Run(opt_Run &run, const opt_Problem &problem, opt_Result &result, uint32_t method)
+{
+    run.problem    = &problem;
+    run.result     = &result;
+    run.one_stream = false;
+    run.stream     = 0;
+    rng_Init(run.rng, problem.seed, rng_OPTIMIZER_STREAM, method, 0);
+}
+
+static double uniform(opt_Run &run)
+{
+    uint64_t hi = rng_Next(run.rng) >> 5;
+    uint64_t lo = rng_Next(run.rng) >> 6;
+    return ((double)((hi << 26) | lo) + 0.5) * (1.0 / 9007199254740992.0); // (0,1), 53 bits
+}
+
+static double gaussian(opt_Run &run)
+{
+    return sqrt(-2.0 * log(uniform(run))) * cos(6.283185307179586 * uniform(run));
+}
+
+static long long evals_Left(const opt_Run &run)
+{
+    return run.problem->max_evals - run.result->n_evals;
+}
+
+//------------------------------------------------------------------
+// residuals of the n points u[j * n_dim ...] (box coordinates); keeps the best
+//------------------------------------------------------------------
+static void evaluate_Batch(opt_Run &run, int n, const double *u, float *residual)
+{
+    const opt_Problem &problem = *run.problem;
+    opt_Result        &result  = *run.result;
+    const int d = problem.n_dim;
+    run.x.resize((size_t)n * d);
+    run.streams.resize(n);
+    for (int j = 0; j < n; j++)
+    {
+        for (int k = 0; k < d; k++)
+        {
+            run.x[j * d + k] = problem.lower[k] + u[j * d + k] * (problem.upper[k] - problem.lower[k]);
+        }
+        run.streams[j] = run.one_stream ? run.stream
+                       : problem.first_stream + (unsigned int)(result.n_evals + (problem.common_streams ? 0 : j));
+    }
+    problem.evaluate(n, d, &run.x[0], &run.streams[0], residual, problem.user);
+    for (int j = 0; j < n; j++)
+    {
+        if (!(residual[j] < HUGE_VALF)) residual[j] = HUGE_VALF; // failed / NaN: worst
+        if (residual[j] < result.residual)
+        {
+            result.residual = residual[j];
+            for (int k = 0; k < d; k++) result.x[k] = run.x[j * d + k];
+        }
+    }
+    result.n_evals += n;
+}
+
+// order[0 ... n-1]: the indices of f from the smallest value up (ties keep their order)
+static void rank_Order(const float *f, int n, int *order)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int j = i;
+        for (; j > 0 && f[order[j - 1]] > f[i]; j--) order[j] = order[j - 1];
+        order[j] = i;
+    }
+}
+
+static void report(opt_Run &run, const char *method, int step)
+{
+    if (run.problem->progress != NULL)
+    {
+        run.problem->progress(method, step, run.result->n_evals, run.result->residual, run.problem->user);
+    }
+}
+
+//------------------------------------------------------------------
+// PSO: the update of main.cpp, the budget spread over (max_evals / n_particles) swarm evaluations
+//------------------------------------------------------------------
+void pso_Minimize(const opt_Problem &problem, int n_particles, opt_Result &result)
+{
+    const int d = problem.n_dim;
+    result.residual = HUGE_VALF;
+    result.n_evals  = 0;
+    opt_Run run;
+    start_Run(run, problem, result, OPT_PSO);
+    if (n_particles > problem.max_evals) n_particles = (int)problem.max_evals;
+    if (n_particles < 1) return;
+    const int   n_updates = (int)(problem.max_evals / n_particles) - 1;
+    const float w_max = 1.0, w_min = 0.3, c1 = 1.05, c2 = 1.05;
+    const float dw    = (w_max - w_min) / (n_updates > 1 ? n_updates - 1 : 1);
+
+    vector<double> X((size_t)n_particles * d), V(X.size()), pbest(X.size()), gbest(d);
+    vector<float>  residual(n_particles), Res_pbest(n_particles);
+    for (size_t j = 0; j < X.size(); j++)
+    {
+        X[j] = uniform(run);
+        V[j] = 0.25 * uniform(run);
+    }
+    evaluate_Batch(run, n_particles, &X[0], &residual[0]);
+    int i_best = 0;
+    for (int i = 0; i < n_particles; i++)
+    {
+        Res_pbest[i] = residual[i];
+        if (residual[i] < residual[i_best]) i_best = i;
+    }
+    pbest = X;
+    float Res_gbest = residual[i_best];
+    for (int k = 0; k < d; k++) gbest[k] = X[i_best * d + k];
+    report(run, "pso", 0);
+
+    for (int it = 0; it < n_updates; it++)
+    {
+        float w = w_min + it * dw;
+        for (int i = 0; i < n_particles; i++)
+        {
+            for (int k = 0; k < d; k++)
+            {
+                size_t j = (size_t)i * d + k;
+                V[j] = w * V[j] + c1 * uniform(run) * (pbest[j] - X[j]) + c2 * uniform(run) * (gbest[k] - X[j]);
+                X[j] = X[j] + V[j];
+            }
+        }
+        evaluate_Batch(run, n_particles, &X[0], &residual[0]);
+        for (int i = 0; i < n_particles; i++)
+        {
+            if (residual[i] <= Res_gbest)
+            {
+                Res_gbest = residual[i];
+                for (int k = 0; k < d; k++) gbest[k] = X[i * d + k];
+            }
+            if (residual[i] <= Res_pbest[i])
+            {
+                Res_pbest[i] = residual[i];
+                for (int k = 0; k < d; k++) pbest[i * d + k] = X[i * d + k];
+            }
+        }
+        report(run, "pso", it + 1);
+    }
+}
+
+//------------------------------------------------------------------
+// eigenvectors (columns of B) and eigenvalues of the symmetric n x n matrix A, cyclic Jacobi
+//------------------------------------------------------------------
+static void symmetric_Eigen(int n, vector<double> A, vector<double> &B, vector<double> &eigen)
+{
+    B.assign((size_t)n * n, 0.0);
+    for (int i = 0; i < n; i++) B[i * n + i] = 1.0;
+    for (int sweep = 0; sweep < 50; sweep++)
+    {
+        double off = 0.0, diag = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            diag += A[i * n + i] * A[i * n + i];
+            for (int j = i + 1; j < n; j++) off += A[i * n + j] * A[i * n + j];
+        }
+        if (off <= 1e-30 * diag) break;
+        for (int p = 0; p < n; p++)
+        {
+            for (int q = p + 1; q < n; q++)
+            {
+                double apq = A[p * n + q];
+                if (fabs(apq) < 1e-300) continue;
+                double theta = (A[q * n + q] - A[p * n + p]) / (2.0 * apq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+                for (int k = 0; k < n; k++) // A P
+                {
+                    double akp = A[k * n + p], akq = A[k * n + q];
+                    A[k * n + p] = c * akp - s * akq;
+                    A[k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) // P^T (A P)
+                {
+                    double apk = A[p * n + k], aqk = A[q * n + k];
+                    A[p * n + k] = c * apk - s * aqk;
+                    A[q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) // B P
+                {
+                    double bkp = B[k * n + p], bkq = B[k * n + q];
+                    B[k * n + p] = c * bkp - s * bkq;
+                    B[k * n + q] = s * bkp + c * bkq;
+                }
+            }
+        }
+    }
+    eigen.resize(n);
+    for (int i = 0; i < n; i++) eigen[i] = A[i * n + i];
+}
+
+//------------------------------------------------------------------
+// CMA-ES from the centre of the box, sigma = 0.3 of its width (Hansen, "The CMA Evolution Strategy:
+// A Tutorial", default strategy parameters)
+//------------------------------------------------------------------
+void cmaes_Minimize(const opt_Problem &problem, int lambda, opt_Result &result)
+{
+    const int n = problem.n_dim;
+    result.residual = HUGE_VALF;
+    result.n_evals  = 0;
+    opt_Run run;
+    start_Run(run, problem, result, OPT_CMAES);
+    if (lambda < 2) lambda = 4 + (int)(3.0 * log((double)n));
+    if (lambda > problem.max_evals) lambda = (int)problem.max_evals;
+    if (lambda < 2) return;
+
+    const int mu = lambda / 2;
+    vector<double> weight(mu);
+    double sum_w = 0.0, sum_w2 = 0.0;
+    for (int i = 0; i < mu; i++)
+    {
+        weight[i] = log(mu + 0.5) - log(i + 1.0);
+        sum_w    += weight[i];
+    }
+    for (int i = 0; i < mu; i++)
+    {
+        weight[i] /= sum_w;
+        sum_w2    += weight[i] * weight[i];
+    }
+    const double mueff = 1.0 / sum_w2;
+    const double cc    = (4.0 + mueff / n) / (n + 4.0 + 2.0 * mueff / n);
+    const double cs    = (mueff + 2.0) / (n + mueff + 5.0);
+    const double c1    = 2.0 / ((n + 1.3) * (n + 1.3) + mueff);
+    const double cmu   = min(1.0 - c1, 2.0 * (mueff - 2.0 + 1.0 / mueff) / ((n + 2.0) * (n + 2.0) + mueff));
+    const double damps = 1.0 + 2.0 * max(0.0, sqrt((mueff - 1.0) / (n + 1.0)) - 1.0) + cs;
+    const double chiN  = sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    double sigma = 0.3;
+    vector<double> mean(n, 0.5), old_mean(n), pc(n, 0.0), ps(n, 0.0), y_w(n), tmp(n);
+    vector<double> C((size_t)n * n, 0.0), B, eigen, D(n, 1.0);
+    for (int i = 0; i < n; i++) C[i * n + i] = 1.0;
+    symmetric_Eigen(n, C, B, eigen);
+    vector<double> U((size_t)lambda * n), Y(U.size()), z(n);
+    vector<float>  residual(lambda);
+    vector<int>    order(lambda);
+
+    for (int gen = 0; evals_Left(run) >= lambda; gen++)
+    {
+        for (int k = 0; k < lambda; k++)
+        {
+            for (int i = 0; i < n; i++) z[i] = D[i] * gaussian(run);
+            for (int i = 0; i < n; i++)
+            {
+                double y = 0.0;
+                for (int j = 0; j < n; j++) y += B[i * n + j] * z[j];
+                U[k * n + i] = mean[i] + sigma * y;
+                Y[k * n + i] = y;
+            }
+        }
+        evaluate_Batch(run, lambda, &U[0], &residual[0]);
+        rank_Order(&residual[0], lambda, &order[0]);
+
+        old_mean = mean;
+        for (int i = 0; i < n; i++)
+        {
+            double m = 0.0;
+            for (int r = 0; r < mu; r++) m += weight[r] * U[order[r] * n + i];
+            mean[i] = m;
+            y_w[i]  = (mean[i] - old_mean[i]) / sigma;
+        }
+        // ps along C^-1/2 y_w = B D^-1 B^T y_w
+        for (int j = 0; j < n; j++)
+        {
+            double t = 0.0;
+            for (int i = 0; i < n; i++) t += B[i * n + j] * y_w[i];
+            tmp[j] = t / D[j];
+        }
+        double norm_ps = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            double t = 0.0;
+            for (int j = 0; j < n; j++) t += B[i * n + j] * tmp[j];
+            ps[i]    = (1.0 - cs) * ps[i] + sqrt(cs * (2.0 - cs) * mueff) * t;
+            norm_ps += ps[i] * ps[i];
+        }
+        norm_ps = sqrt(norm_ps);
+        const bool hsig = norm_ps / sqrt(1.0 - pow(1.0 - cs, 2.0 * (gen + 1))) / chiN < 1.4 + 2.0 / (n + 1.0);
+        for (int i = 0; i < n; i++)
+        {
+            pc[i] = (1.0 - cc) * pc[i] + (hsig ? sqrt(cc * (2.0 - cc) * mueff) : 0.0) * y_w[i];
+        }
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j <= i; j++)
+            {
+                double rank_mu = 0.0;
+                for (int r = 0; r < mu; r++) rank_mu += weight[r] * Y[order[r] * n + i] * Y[order[r] * n + j];
+                double c = (1.0 - c1 - cmu) * C[i * n + j]
+                         + c1 * (pc[i] * pc[j] + (hsig ? 0.0 : cc * (2.0 - cc) * C[i * n + j]))
+                         + cmu * rank_mu;
+                C[i * n + j] = C[j * n + i] = c;
+            }
+        }
+        sigma *= exp((cs / damps) * (norm_ps / chiN - 1.0));
+
+        symmetric_Eigen(n, C, B, eigen);
+        double D_max = 0.0;
+        for (int i = 0; i < n; i++)
+        {
+            D[i]  = sqrt(max(eigen[i], 1e-20));
+            D_max = max(D_max, D[i]);
+        }
+        report(run, "cmaes", gen + 1);
+        if (sigma * D_max < 1e-7) break; // converged far below the Monte Carlo noise
+    }
+}
+
+//------------------------------------------------------------------
+// Nelder-Mead (reflection 1, expansion 2, contraction 1/2, shrink 1/2); the steps are serial, so
+// this is a short local polish and not a search
+//------------------------------------------------------------------
+void nelder_Mead_Polish(const opt_Problem &problem, double step, opt_Result &result)
+{
+    const int n = problem.n_dim;
+    opt_Run run;
+    start_Run(run, problem, result, 0); // draws nothing
+    opt_Problem budget = problem; // max_evals counts the evaluations of the polish
+    budget.max_evals   = result.n_evals + problem.max_evals;
+    run.problem    = &budget;
+    run.one_stream = true;
+    run.stream     = problem.first_stream;
+    if (evals_Left(run) < n + 1) return;
+
+    vector<double> V((size_t)(n + 1) * n), centre(n), xr(n), xe(n), xc(n);
+    vector<float>  f(n + 1);
+    vector<int>    order(n + 1);
+    for (int k = 0; k < n; k++)
+    {
+        double u = (result.x[k] - problem.lower[k]) / (problem.upper[k] - problem.lower[k]);
+        for (int v = 0; v <= n; v++) V[v * n + k] = u;
+        V[(k + 1) * n + k] = u + step;
+    }
+    result.residual = HUGE_VALF; // from here on: residuals on the polish stream
+    evaluate_Batch(run, n + 1, &V[0], &f[0]);
+
+    for (int it = 1; evals_Left(run) > 0; it++)
+    {
+        rank_Order(&f[0], n + 1, &order[0]);
+        const int best = order[0], second = order[n - 1], worst = order[n];
+        double size = 0.0;
+        for (int v = 0; v <= n; v++)
+        {
+            for (int k = 0; k < n; k++) size = max(size, fabs(V[v * n + k] - V[best * n + k]));
+        }
+        if (size < 1e-6) break;
+        for (int k = 0; k < n; k++)
+        {
+            double c = 0.0;
+            for (int v = 0; v <= n; v++) if (v != worst) c += V[v * n + k];
+            centre[k] = c / n;
+            xr[k] = 2.0 * centre[k] - V[worst * n + k];
+        }
+        float fr;
+        evaluate_Batch(run, 1, &xr[0], &fr);
+        const double *accept = NULL;
+        float f_accept = fr;
+        if (fr < f[best])
+        {
+            accept = &xr[0];
+            if (evals_Left(run) > 0)
+            {
+                for (int k = 0; k < n; k++) xe[k] = centre[k] + 2.0 * (xr[k] - centre[k]);
+                float fe;
+                evaluate_Batch(run, 1, &xe[0], &fe);
+                if (fe < fr) { accept = &xe[0]; f_accept = fe; }
+            }
+        }
+        else if (fr < f[second])
+        {
+            accept = &xr[0];
+        }
+        else if (evals_Left(run) > 0)
+        {
+            const bool outside = fr < f[worst];
+            for (int k = 0; k < n; k++) xc[k] = centre[k] + 0.5 * ((outside ? xr[k] : V[worst * n + k]) - centre[k]);
+            float fc;
+            evaluate_Batch(run, 1, &xc[0], &fc);
+            if (outside ? fc <= fr : fc < f[worst])
+            {
+                accept = &xc[0];
+                f_accept = fc;
+            }
+            else if (evals_Left(run) >= n) // shrink towards the best vertex
+            {
+                vector<double> S;
+                for (int v = 0; v <= n; v++)
+                {
+                    if (v == best) continue;
+                    for (int k = 0; k < n; k++) V[v * n + k] = V[best * n + k] + 0.5 * (V[v * n + k] - V[best * n + k]);
+                    S.insert(S.end(), V.begin() + v * n, V.begin() + (v + 1) * n);
+                }
+                vector<float> fs(n);
+                evaluate_Batch(run, n, &S[0], &fs[0]);
+                for (int v = 0, j = 0; v <= n; v++) if (v != best) f[v] = fs[j++];
+            }
+        }
+        if (accept != NULL)
+        {
+            for (int k = 0; k < n; k++) V[worst * n + k] = accept[k];
+            f[worst] = f_accept;
+        }
+        report(run, "nelder-mead", it);
+    }
+}
@@ -0,0 +1,68 @@
+/*-----------------------------------------------------------------------------------------------------
+// Gradient-free optimizers over the log10 rates (--optimizer, --fit, --polish).
+//
+// An optimizer only sees a box of n_dim log10 rates and a batch callback: "residuals of these n
+// parameter vectors". main implements the callback on top of evaluate_Particles' machinery (MPI ranks,
+// OpenMP threads, residual cache), so every optimizer gets the parallel residual engine for free as
+// long as it asks for many points at once.
+//
+//      pso_Minimize       : the swarm of main.cpp (inertia 0.3 -> 1, c1 = c2 = 1.05) in n dimensions
+//      cmaes_Minimize     : CMA-ES (Hansen's (mu/mu_w, lambda) with rank-one and rank-mu covariance
+//                           updates); lambda = 4 + 3 ln(n_dim) evaluations per generation by default
+//      nelder_Mead_Polish : downhill simplex from a given point, e.g. the best of the other two; all
+//                           of its evaluations use one random stream (common random numbers), so the
+//                           simplex compares rates and not Monte Carlo noise
+//
+// The box is where the optimizers start (and the scale of their first steps), not a constraint: like the
+// particles of main.cpp they may leave it. The draws of the optimizers come from the Philox
+// stream rng_OPTIMIZER_STREAM of the seed, so every MPI rank runs the same optimizer and reaches the
+// same positions without a broadcast. Evaluation j of a run (counted from 0) simulates with stream
+// first_stream + j, or first_stream + the first evaluation of its batch with common_streams.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "serca_Model.h"
+
+const int max_Opt_Dim = n_Rates;
+
+// residual[j] of the n parameter vectors x[j * n_dim ...] (log10 k), simulated with stream streams[j]
+typedef void (*opt_Batch)(int n, int n_dim, const double *x, const unsigned int *streams, float *residual, void *user);
+// after every iteration / generation / simplex step; best is the best residual so far
+typedef void (*opt_Progress)(const char *method, int step, long long n_evals, float best, void *user);
+
+enum opt_Method { OPT_PSO = 0, OPT_CMAES };
+
+struct opt_Problem
+{
+    int                n_dim;
+    double             lower[max_Opt_Dim], upper[max_Opt_Dim]; // starting box in log10 k
+    opt_Batch          evaluate;
+    opt_Progress       progress;       // NULL: silent
+    void              *user;           // passed to both callbacks
+    unsigned long long seed;
+    unsigned int       first_stream;   // stream of the first evaluation
+    bool               common_streams; // a batch shares one stream (--crn)
+    long long          max_evals;      // budget of residual evaluations
+};
+
+struct opt_Result
+{
+    double    x[max_Opt_Dim]; // best position, log10 k
+    float     residual;
+    long long n_evals;        // residual evaluations used
+};
+
+// "pso" | "cmaes"; false for anything else
+bool parse_Opt_Method(const char *name, opt_Method &method);
+const char *opt_Method_Name(opt_Method method);
+
+void pso_Minimize  (const opt_Problem &problem, int n_particles, opt_Result &result);
+void cmaes_Minimize(const opt_Problem &problem, int lambda, opt_Result &result); // lambda 0: default
+
+// from result.x with simplex edges of step (fraction of the box); result is replaced by the best vertex
+// (its residual on the polish stream); up to problem.max_evals evaluations
+void nelder_Mead_Polish(const opt_Problem &problem, double step, opt_Result &result);
+
+#endif
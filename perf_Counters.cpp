@@ -0,0 +1,156 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Kernel counters (see perf_Counters.h). Without USE_COUNTERS this file is empty.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include "perf_Counters.h"
+
+#ifdef USE_COUNTERS
+
+#include <string.h>
+#include <chrono>
+#include "rng_Philox.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PERF_TSC 1
+#endif
+
+using namespace std;
+
+static const char *kernel_Names[n_Kernels] = { "fixed-dt", "fused", "gillespie", "cme", "tables", "binning", "population" };
+static const char *state_Names[n_States]   = { "S0", "S1", "S2", "S3", "S4", "S5", "S6a", "S7", "S6", "S8", "S9", "S10", "S11" };
+
+static perf_Counters process_Total; // guarded by critical(perf_total)
+
+perf_Counters &perf_Thread()
+{
+    static thread_local perf_Counters counters; // zero-initialized
+    return counters;
+}
+
+uint64_t perf_Ticks()
+{
+#ifdef PERF_TSC
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void perf_Clear(perf_Counters &counters)
+{
+    memset(&counters, 0, sizeof(counters));
+}
+
+void perf_Diff(const perf_Counters &now, const perf_Counters &before, perf_Counters &delta)
+{
+    const uint64_t *a = (const uint64_t *)&now, *b = (const uint64_t *)&before;
+    uint64_t       *d = (uint64_t *)&delta;
+    for (int w = 0; w < perf_Words; w++) d[w] = a[w] - b[w];
+}
+
+void perf_Add_Total(const perf_Counters &delta)
+{
+    const uint64_t *d = (const uint64_t *)&delta;
+    #pragma omp critical (perf_total)
+    {
+        uint64_t *t = (uint64_t *)&process_Total;
+        for (int w = 0; w < perf_Words; w++) t[w] += d[w];
+    }
+}
+
+void perf_Take_Total(perf_Counters &total)
+{
+    #pragma omp critical (perf_total)
+    {
+        total = process_Total;
+        perf_Clear(process_Total);
+    }
+}
+
+void perf_End_Call(const perf_Counters &before, bool print)
+{
+    perf_Counters delta;
+    perf_Diff(perf_Thread(), before, delta);
+    if (print) perf_Print_Line(cout, delta);
+    perf_Add_Total(delta);
+}
+
+static uint64_t sum(const uint64_t *x, int n)
+{
+    uint64_t s = 0;
+    for (int i = 0; i < n; i++) s += x[i];
+    return s;
+}
+
+void perf_Print_Line(ostream &out, const perf_Counters &c)
+{
+    uint64_t steps = sum(c.steps, n_States), moves = sum(c.moves, n_States);
+    out << "       Counters : ";
+    for (int k = 0; k < n_Kernels; k++)
+    {
+        if (c.calls[k] > 0) out << kernel_Names[k] << " " << c.ticks[k] / 1e6 << " Mticks, ";
+    }
+    out << c.rng_draws << " draws, " << c.acc_updates << " binned";
+    if (steps > 0) out << ", " << 100.0 * moves / steps << " % of the steps moved";
+    if (sum(c.jumps, n_States) > 0) out << ", " << sum(c.jumps, n_States) << " jumps";
+    out << std::endl;
+}
+
+void perf_Print_Block(ostream &out, const perf_Counters &c)
+{
+    out << " Kernel counters         :";
+    for (int k = 0; k < n_Kernels; k++)
+    {
+        if (c.calls[k] > 0) out << " " << kernel_Names[k] << " " << c.ticks[k] / 1e6 << " Mticks (" << c.calls[k] << " calls)";
+    }
+    out << "\n";
+    out << "                           " << c.rng_draws << " random numbers drawn, " << c.acc_updates << " accumulator updates\n";
+    uint64_t steps = sum(c.steps, n_States), jumps = sum(c.jumps, n_States);
+    if (steps > 0)
+    {
+        out << "                           fixed-dt steps (moved / taken) :";
+        for (int s = 0; s < n_States; s++)
+        {
+            if (c.steps[s] > 0) out << " " << state_Names[s] << " " << c.moves[s] << "/" << c.steps[s];
+        }
+        out << "\n";
+    }
+    if (jumps > 0)
+    {
+        out << "                           gillespie jumps out of :";
+        for (int s = 0; s < n_States; s++)
+        {
+            if (c.jumps[s] > 0) out << " " << state_Names[s] << " " << c.jumps[s];
+        }
+        out << "\n";
+    }
+    out.flush();
+}
+
+void perf_Count_Steps(const transition_Table &table, unsigned long long seed, unsigned int stream_id, int pCa,
+                      const uint8_t *states, int first_molecule, int n_molecules, int step_begin, int step_end)
+{
+    perf_Counters &c = perf_Thread();
+    for (int j = 0; j < n_molecules; j++)
+    {
+        philox_Stream rng;
+        rng_Init(rng, seed, stream_id, pCa, first_molecule + j);
+        rng_Seek(rng, step_begin);
+        int state = states[j];
+        for (int n = step_begin; n < step_end; n++)
+        {
+            int from = state;
+            update_States(state, rng_Uniform(rng), table);
+            c.steps[from]++;
+            c.moves[from] += (state != from);
+        }
+    }
+}
+
+#endif // USE_COUNTERS
@@ -0,0 +1,93 @@
+/*-----------------------------------------------------------------------------------------------------
+// Hot-path counters of the Monte Carlo kernels (make counters, i.e. -DUSE_COUNTERS; compiled out otherwise).
+//
+// Every thread counts into its own perf_Counters:
+//      ticks / calls   per kernel: fixed-dt stepping, fused stepping, Gillespie, CME, transition tables,
+//                      occupancy binning (ss_Add_States). Ticks are TSC cycles on x86, nanoseconds elsewhere.
+//      steps / moves   fixed-dt molecule steps started in each state, and how many of them left the state
+//                      (the others drew a number and stayed: the no-op steps)
+//      jumps           Gillespie transitions out of each state
+//      rng_draws       uniform numbers drawn
+//      acc_updates     fixed-dt molecule-samples binned, Gillespie dwell intervals added inside the window
+// The step/move histogram is taken by replaying the draws of a block through the scalar update_States
+// before the (vector) kernel runs, outside its timer: the counters build runs slower, the kernel ticks
+// stay those of the real kernel.
+//
+// get_Residual prints the counters of each call (with --verbosity 1) and adds them to the process total,
+// which main reports and clears once per PSO iteration.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <iostream>
+#include "update_States.h"
+
+enum perf_Kernel { KERNEL_FIXED_DT = 0, KERNEL_FUSED, KERNEL_GILLESPIE, KERNEL_CME, KERNEL_TABLES, KERNEL_BINNING, KERNEL_POPULATION, n_Kernels };
+
+struct perf_Counters // only uint64_t members: it is also handled as an array of words
+{
+    uint64_t ticks[n_Kernels];
+    uint64_t calls[n_Kernels];
+    uint64_t steps[n_States];
+    uint64_t moves[n_States];
+    uint64_t jumps[n_States];
+    uint64_t rng_draws;
+    uint64_t acc_updates;
+};
+
+const int perf_Words = sizeof(perf_Counters) / sizeof(uint64_t);
+
+#ifdef USE_COUNTERS
+
+perf_Counters &perf_Thread(); // the counters of the calling thread
+uint64_t       perf_Ticks();
+
+void perf_Clear(perf_Counters &counters);
+void perf_Diff (const perf_Counters &now, const perf_Counters &before, perf_Counters &delta);
+void perf_Add_Total(const perf_Counters &delta); // into the process total (thread safe)
+void perf_Take_Total(perf_Counters &total);      // the process total since the last call, then cleared
+
+// one line (the counters of a get_Residual call) or a block (an iteration summary)
+void perf_Print_Line (std::ostream &out, const perf_Counters &counters);
+void perf_Print_Block(std::ostream &out, const perf_Counters &counters);
+
+// fixed-dt step/move histogram of molecules [first_molecule, first_molecule + n_molecules) over steps [step_begin, step_end)
+void perf_Count_Steps(const transition_Table &table, unsigned long long seed, unsigned int stream_id, int pCa,
+                      const uint8_t *states, int first_molecule, int n_molecules, int step_begin, int step_end);
+
+// adds the ticks of its scope to a kernel
+struct perf_Timer
+{
+    perf_Kernel kernel;
+    uint64_t    start;
+    perf_Timer(perf_Kernel k) : kernel(k), start(perf_Ticks()) {}
+    ~perf_Timer()
+    {
+        perf_Counters &c = perf_Thread();
+        c.ticks[kernel] += perf_Ticks() - start;
+        c.calls[kernel]++;
+    }
+};
+
+// end of a get_Residual call begun with the counters in before: printed if print, added to the process total
+void perf_End_Call(const perf_Counters &before, bool print);
+
+#define PERF_TIMER(kernel)     perf_Timer perf_timer_scope(kernel)
+#define PERF_ADD(field, n)     (perf_Thread().field += (uint64_t)(n))
+#define PERF_COUNT_STEPS(args) perf_Count_Steps args
+#define PERF_CALL_BEGIN        const perf_Counters perf_call_before = perf_Thread()
+#define PERF_CALL_END(print)   perf_End_Call(perf_call_before, print)
+
+#else
+
+#define PERF_TIMER(kernel)
+#define PERF_ADD(field, n)
+#define PERF_COUNT_STEPS(args)
+#define PERF_CALL_BEGIN
+#define PERF_CALL_END(print)
+
+#endif
+
+#endif
@@ -0,0 +1,202 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Population-level simulation of the SERCA scheme (see population_Engine.h).
+//
+// Step matrix  : M = I + D, D[s][to] = branch probability of s -> to per step, D[s][s] = -(sum of them).
+//                Every entry of D is of order rate * dt ~ 1e-3, so the powers are kept in the same form,
+//                M^n = I + D_n, and multiplied as (I + A)(I + B) = I + (A + B + A B): the 1 of the
+//                diagonal never swallows the small off-diagonal probabilities the way it would in M^n.
+//
+// Multinomial  : the n molecules in s go to state j with the row p_j of M^n. Drawn as a chain of
+//                binomials, n_j = Binomial(n - taken, p_j / (p_j + ... + p_stay)), staying last.
+//
+// Binomial     : inversion while n * min(p, 1 - p) < 10, otherwise BTRS (Hoermann 1993, transformed
+//                rejection with squeeze), about 1.2 uniform pairs per draw whatever n is.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+#include "rng_Philox.h"
+#include "population_Engine.h"
+#include "perf_Counters.h"
+
+const int binomial_Inversion = 10; // n * p below which the binomial is drawn by inversion
+
+//------------------------------------------------------------------
+// 53 random bits -> double in (0,1)
+//------------------------------------------------------------------
+static inline double uniform_Open(philox_Stream &rng)
+{
+    uint64_t hi = rng_Next(rng) >> 5; // 27 bits
+    uint64_t lo = rng_Next(rng) >> 6; // 26 bits
+    return ((double)((hi << 26) | lo) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+//------------------------------------------------------------------
+// log(k!) - exact for small k, Stirling series beyond (lgamma is not thread-safe everywhere)
+//------------------------------------------------------------------
+static double log_Factorial(int k)
+{
+    if (k < 16)
+    {
+        double sum = 0.0;
+        for (int i = 2; i <= k; i++) sum += log((double)i);
+        return sum;
+    }
+    double x = k + 1.0;
+    double r = 1.0 / (x * x);
+    return (x - 0.5) * log(x) - x + 0.91893853320467274178 + (1.0 / 12.0 - r * (1.0 / 360.0 - r / 1260.0)) / x;
+}
+
+static int binomial_Inverse(philox_Stream &rng, int n, double p)
+{
+    double q    = 1.0 - p;
+    double s    = p / q;
+    double a    = (n + 1) * s;
+    double prob = pow(q, n);
+    double u    = uniform_Open(rng);
+    int    k    = 0;
+    while (u > prob && k < n)
+    {
+        u    -= prob;
+        k++;
+        prob *= a / k - s;
+    }
+    return k;
+}
+
+static int binomial_BTRS(philox_Stream &rng, int n, double p)
+{
+    double q     = 1.0 - p;
+    double spq   = sqrt(n * p * q);
+    double b     = 1.15 + 2.53 * spq;
+    double a     = -0.0873 + 0.0248 * b + 0.01 * p;
+    double c     = n * p + 0.5;
+    double v_r   = 0.92 - 4.2 / b;
+    double alpha = (2.83 + 5.1 / b) * spq;
+    double lpq   = log(p / q);
+    int    m     = (int)floor((n + 1) * p);
+    double h     = log_Factorial(m) + log_Factorial(n - m);
+    for (;;)
+    {
+        double u  = uniform_Open(rng) - 0.5;
+        double v  = uniform_Open(rng);
+        double us = 0.5 - fabs(u);
+        int    k  = (int)floor((2.0 * a / us + b) * u + c);
+        if (k < 0 || k > n) continue;
+        if (us >= 0.07 && v <= v_r) return k; // squeeze
+        v = log(v * alpha / (a / (us * us) + b));
+        if (v <= h - log_Factorial(k) - log_Factorial(n - k) + (k - m) * lpq) return k;
+    }
+}
+
+static int binomial(philox_Stream &rng, int n, double p)
+{
+    if (n <= 0 || p <= 0.0) return 0;
+    if (p >= 1.0) return n;
+    if (p > 0.5) return n - binomial(rng, n, 1.0 - p);
+    if (n * p < binomial_Inversion) return binomial_Inverse(rng, n, p);
+    return binomial_BTRS(rng, n, p);
+}
+
+//------------------------------------------------------------------
+// C = A + B + A B, i.e. (I + A)(I + B) = I + C
+//------------------------------------------------------------------
+static void step_Mul(const double A[n_States][n_States], const double B[n_States][n_States], double C[n_States][n_States])
+{
+    double T[n_States][n_States];
+    for (int i = 0; i < n_States; i++)
+    {
+        for (int j = 0; j < n_States; j++)
+        {
+            double sum = A[i][j] + B[i][j];
+            for (int k = 0; k < n_States; k++) sum += A[i][k] * B[k][j];
+            T[i][j] = sum;
+        }
+    }
+    memcpy(C, T, sizeof(T));
+}
+
+//------------------------------------------------------------------
+// M^n - I by squaring
+//------------------------------------------------------------------
+static void step_Power(const double D[n_States][n_States], int n, double P[n_States][n_States])
+{
+    double square[n_States][n_States];
+    memcpy(square, D, sizeof(square));
+    memset(P, 0, sizeof(double) * n_States * n_States);
+    while (n > 0)
+    {
+        if (n & 1) step_Mul(P, square, P);
+        n >>= 1;
+        if (n > 0) step_Mul(square, square, square);
+    }
+}
+
+//------------------------------------------------------------------
+// one jump of n steps: pop = pop * M^n, drawn (P = M^n - I)
+//------------------------------------------------------------------
+static void population_Jump(philox_Stream &rng, const double P[n_States][n_States], int pop[n_States])
+{
+    int moved[n_States] = {0};
+    for (int s = 0; s < n_States; s++)
+    {
+        int left = pop[s];
+        if (left == 0) continue;
+        double rest = 1.0; // probability of the states not drawn yet, staying included
+        for (int to = 0; to < n_States && left > 0; to++)
+        {
+            if (to == s || P[s][to] <= 0.0) continue;
+            int k = binomial(rng, left, P[s][to] / rest);
+            moved[to] += k;
+            left      -= k;
+            rest      -= P[s][to];
+            if (rest < 0.0) rest = 0.0;
+        }
+        moved[s] += left;
+    }
+    memcpy(pop, moved, sizeof(moved));
+}
+
+void population_Accumulate(const transition_Table &table,
+                           unsigned long long seed, unsigned int stream_id, int pCa,
+                           int first_molecule, int n_molecules, const ss_Window &window,
+                           ss_Accumulator &acc)
+{
+    PERF_TIMER(KERNEL_POPULATION);
+    int first_sample = first_Sample(window);
+    if (n_molecules <= 0 || first_sample >= window.end) return;
+
+    double D[n_States][n_States] = {{0}};
+    for (int s = 0; s < n_States; s++)
+    {
+        double prob[max_Branch + 1];
+        branch_Probabilities(table, s, prob);
+        for (int k = 0; k < max_Branch; k++)
+        {
+            D[s][table.next[s][k]] += prob[k];
+            D[s][s]                -= prob[k];
+        }
+    }
+    // the sample at step n is the state after the update of step n (as in fixed_Dt_Accumulate)
+    double to_first[n_States][n_States], to_next[n_States][n_States];
+    step_Power(D, first_sample + 1, to_first);
+    step_Power(D, window.stride, to_next);
+
+    philox_Stream rng;
+    rng_Init(rng, seed, stream_id, pCa, first_molecule);
+    int pop[n_States] = {0};
+    pop[0] = n_molecules; // every SERCA starts in state 0
+    for (int n = first_sample; n < window.end; n += window.stride)
+    {
+        population_Jump(rng, (n == first_sample) ? to_first : to_next, pop);
+        for (int s = 0; s < n_States; s++) acc.count[s] += pop[s];
+        acc.n_samples += n_molecules;
+        PERF_ADD(acc_updates, n_States);
+    }
+}
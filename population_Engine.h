@@ -0,0 +1,30 @@
+/*-----------------------------------------------------------------------------------------------------
+// Population-level simulation of the SERCA scheme (--engine population).
+//
+// The molecules do not interact, so all the fixed-dt engine needs to know at a sample point is how many
+// molecules are in each of the 13 states. Over n steps a molecule in state s ends up in state j with
+// probability M^n[s][j], M the one-step transition matrix of the transition_Table; the molecules in s
+// therefore spread over the states as one multinomial draw (a chain of binomials) with that row. The
+// engine jumps from S0 straight to the first sample point and then from sample point to sample point,
+// drawing 13 multinomials per jump: exact in distribution for the fixed-dt chain (no leap error, the
+// leap is the matrix power), with a cost independent of the number of molecules, so 1e6 or more
+// molecules per point cost what a few do.
+//
+// The draws of molecules [first_molecule, first_molecule + n_molecules) come from the Philox stream
+// (stream_id, pCa, first_molecule): a batch is one stream, and the populations are independent of those
+// of the fixed-dt engine with the same streams. The samples are those of the fixed window (--ss-detect is
+// a fixed-dt option).
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef POPULATION_ENGINE_H
+#define POPULATION_ENGINE_H
+
+#include "update_States.h"
+#include "steady_State.h"
+
+void population_Accumulate(const transition_Table &table,
+                           unsigned long long seed, unsigned int stream_id, int pCa,
+                           int first_molecule, int n_molecules, const ss_Window &window,
+                           ss_Accumulator &acc);
+
+#endif
@@ -0,0 +1,136 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Residual memoization on log-quantized rate vectors (see residual_Cache.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <string.h>
+#include "residual_Cache.h"
+
+void cache_Init(residual_Cache &cache, float resolution, size_t max_entries)
+{
+    cache.enabled     = resolution > 0;
+    cache.resolution  = resolution;
+    cache.max_entries = max_entries;
+    cache.stats.hits  = cache.stats.refined = cache.stats.misses = 0;
+    cache.entries.clear();
+}
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *byte = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ byte[i]) * 1099511628211ULL;
+    return hash;
+}
+
+// what the residual depends on besides the rates and the molecule count (exact values, no binning)
+static uint64_t condition_Hash(const serca_Model &model, const sim_Config &config, const exp_Data &data)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const int   simulation[6] = { config.engine, config.window.begin, config.window.end, config.window.stride,
+                                  config.window.detect, config.window.detect ? config.window.block : 0 };
+    const float detection[2]  = { config.window.detect ? config.window.drift_tol : 0.0f, config.window.detect ? config.window.n_eff : 0.0f };
+    hash = fnv1a(hash, simulation, sizeof(simulation));
+    hash = fnv1a(hash, detection,  sizeof(detection));
+    const float conc[5] = { model.Ca_sr_conc, model.Pi_conc, model.MgATP_conc, model.MgADP_conc, model.dt };
+    hash = fnv1a(hash, conc, sizeof(conc));
+    hash = fnv1a(hash, &model.topology, sizeof(model.topology));
+    hash = fnv1a(hash, &data.n_points, sizeof(data.n_points));
+    hash = fnv1a(hash, data.conc,       data.n_points * sizeof(float));
+    hash = fnv1a(hash, data.norm_bound, data.n_points * sizeof(float));
+    for (int d = 0; d < data.n_datasets; d++)
+    {
+        const exp_Dataset &set = data.set[d];
+        const float values[2]  = { set.weight, set.Ca_cyt_conc };
+        const int   layout[3]  = { set.kind, set.first, set.n_points };
+        hash = fnv1a(hash, values, sizeof(values));
+        hash = fnv1a(hash, layout, sizeof(layout));
+    }
+    return hash;
+}
+
+// log10 bins of all rates, and the FNV-1a hash of the bins and the condition
+static uint64_t quantize(const residual_Cache &cache, const serca_Model &model, uint64_t condition, int32_t bin[n_Rates])
+{
+    uint64_t hash = condition;
+    for (int r = 0; r < n_Rates; r++)
+    {
+        double k = model.rates[r];
+        bin[r] = (k > 0) ? (int32_t)floor(log10(k) / cache.resolution) : INT32_MIN;
+        for (int b = 0; b < 4; b++)
+        {
+            hash = (hash ^ ((uint32_t)bin[r] >> (8 * b) & 0xFF)) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+float cached_Residual(residual_Cache &cache, const serca_Model &model, const sim_Config &config, const exp_Data &data,
+                      unsigned long long seed, unsigned int stream_id,
+                      const adaptive_Config &adaptive, float prune_above, int &molecules_used)
+{
+    if (!cache.enabled)
+    {
+        return get_Residual(model, config, data, seed, stream_id, adaptive, prune_above, molecules_used);
+    }
+    int32_t  bin[n_Rates];
+    uint64_t condition = condition_Hash(model, config, data);
+    uint64_t key       = quantize(cache, model, condition, bin);
+    bool     found = false;
+    bool     hit   = false;
+    residual_State state;
+    state.n_molecules = 0;
+    #pragma omp critical (residual_cache)
+    {
+        std::unordered_map<uint64_t, cache_Entry>::const_iterator entry = cache.entries.find(key);
+        if (entry != cache.entries.end() && entry->second.condition == condition && memcmp(entry->second.bin, bin, sizeof(bin)) == 0)
+        {
+            // enough molecules, or stopped by the adaptive tolerance within a budget at least this large
+            found = true;
+            state = entry->second.state;
+            hit   = state.n_molecules >= config.n_molecules || (!state.pruned && entry->second.budget >= config.n_molecules);
+            if (hit) cache.stats.hits++;
+            else     cache.stats.refined++;
+        }
+        else
+        {
+            cache.stats.misses++;
+        }
+    }
+    if (hit)
+    {
+        molecules_used = 0; // nothing simulated
+        return state.residual;
+    }
+
+    float residual = get_Residual(model, config, data, seed, stream_id, adaptive, prune_above, molecules_used, &state);
+
+    #pragma omp critical (residual_cache)
+    {
+        if (found || cache.entries.size() < cache.max_entries)
+        {
+            cache_Entry &entry = cache.entries[key];
+            memcpy(entry.bin, bin, sizeof(bin));
+            entry.condition = condition;
+            entry.budget    = config.n_molecules;
+            entry.state     = state;
+        }
+    }
+    return residual;
+}
+
+cache_Stats cache_Take_Stats(residual_Cache &cache)
+{
+    cache_Stats stats;
+    #pragma omp critical (residual_cache)
+    {
+        stats = cache.stats;
+        cache.stats.hits = cache.stats.refined = cache.stats.misses = 0;
+    }
+    return stats;
+}
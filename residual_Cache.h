@@ -0,0 +1,56 @@
+/*-----------------------------------------------------------------------------------------------------
+// Memoized residuals (--cache RESOLUTION).
+//
+// Late in a PSO run many particles come back to nearly the same rates. The cache maps the rate vector,
+// quantized on a log scale (bins of RESOLUTION in log10 k, i.e. rates within a factor 10^RESOLUTION share
+// an entry), to what get_Residual simulated there (residual_State). A lookup that finds an entry with
+// the requested molecules returns its residual (hit); an entry with fewer molecules, e.g. one the
+// adaptive mode pruned or one of a lower --fidelity level, is refined by simulating only the missing
+// molecules on its streams (refined); otherwise the residual is simulated and stored (miss). The key
+// also covers the condition: the engine and steady-state window, the fixed concentrations, dt and
+// topology of the model and the experimental curves, so one cache can serve several conditions at once
+// (./sweep). All calls are thread safe; every MPI rank has its own cache.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef RESIDUAL_CACHE_H
+#define RESIDUAL_CACHE_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include "get_Residual.h"
+
+struct cache_Stats
+{
+    long long hits;    // residual taken from the cache
+    long long refined; // entry with fewer molecules, only the missing ones simulated
+    long long misses;  // simulated from scratch
+};
+
+struct cache_Entry
+{
+    int32_t        bin[n_Rates]; // the quantized rates (the map is keyed by their hash)
+    uint64_t       condition;    // hash of the engine, window, concentrations and data
+    int            budget;       // config.n_molecules of the call that stored it
+    residual_State state;
+};
+
+struct residual_Cache
+{
+    bool        enabled;
+    float       resolution;  // bin width in log10 of every rate
+    size_t      max_entries; // no new entries once full (--cache-max)
+    cache_Stats stats;       // since the last cache_Take_Stats
+    std::unordered_map<uint64_t, cache_Entry> entries; // by hash of the quantized rates
+};
+
+void cache_Init(residual_Cache &cache, float resolution, size_t max_entries);
+
+// get_Residual of model, through the cache
+float cached_Residual(residual_Cache &cache, const serca_Model &model, const sim_Config &config, const exp_Data &data,
+                      unsigned long long seed, unsigned int stream_id,
+                      const adaptive_Config &adaptive, float prune_above, int &molecules_used);
+
+// the counters since the last call, then reset
+cache_Stats cache_Take_Stats(residual_Cache &cache);
+
+#endif
@@ -0,0 +1,118 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Counter-based random numbers for the SERCA Monte Carlo.
+//
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011) maps a
+// 128-bit counter and a 64-bit key to 128 random bits without any hidden state. Every SERCA
+// molecule therefore gets its own stream by putting its coordinates into the counter:
+//
+//      key    = run seed (64 bit)
+//      ctr[0] = block number   (4 draws per block, advances as the molecule is stepped)
+//      ctr[1] = molecule index
+//      ctr[2] = pCa index
+//      ctr[3] = stream id      (one per particle evaluation)
+//
+// A stream can be positioned on any draw with rng_Seek, so the numbers a molecule sees do not
+// depend on which thread or rank simulates it, nor in which order the molecules are run.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef RNG_PHILOX_H
+#define RNG_PHILOX_H
+
+#include <stdint.h>
+
+// the generator can also be compiled into device kernels (nvcc / hipcc)
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define RNG_HD __host__ __device__
+#else
+#define RNG_HD
+#endif
+
+const uint32_t rng_LASTRUN_STREAM   = 0xFFFFFFFFu; // stream id reserved for the final lastRun pass
+const uint32_t rng_OPTIMIZER_STREAM = 0xFFFFFFFDu; // stream id of the draws of the optimizers (optimizer.h)
+const uint32_t rng_ALL_PCA          = 0xFFFFFFFFu; // pCa index of the streams shared by all pCa points (fused sweep)
+
+struct philox_Stream
+{
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t block[4]; // random bits of the current block
+    int      used;     // how many words of block[] have been handed out
+};
+
+//------------------------------------------------------------------
+// one Philox4x32 block: 10 rounds of multiply / xor / key bump
+//------------------------------------------------------------------
+RNG_HD inline void philox4x32_10(const uint32_t in[4], const uint32_t key_in[2], uint32_t out[4])
+{
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u; // round multipliers
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u; // Weyl key increments
+    uint32_t c0 = in[0], c1 = in[1], c2 = in[2], c3 = in[3];
+    uint32_t k0 = key_in[0], k1 = key_in[1];
+    for (int r = 0; r < 10; r++)
+    {
+        uint64_t p0 = (uint64_t)M0 * c0;
+        uint64_t p1 = (uint64_t)M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n1 = (uint32_t)p1;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        uint32_t n3 = (uint32_t)p0;
+        c0 = n0; c1 = n1; c2 = n2; c3 = n3;
+        k0 += W0; k1 += W1;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+//------------------------------------------------------------------
+// 24 random bits -> float in [0,1)
+//------------------------------------------------------------------
+RNG_HD inline float rng_To_Float(uint32_t x)
+{
+    return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+RNG_HD inline void rng_Init(philox_Stream &s, unsigned long long seed, uint32_t stream_id, uint32_t pCa, uint32_t molecule)
+{
+    s.key[0] = (uint32_t)seed;
+    s.key[1] = (uint32_t)(seed >> 32);
+    s.ctr[0] = 0;
+    s.ctr[1] = molecule;
+    s.ctr[2] = pCa;
+    s.ctr[3] = stream_id;
+    s.used   = 4; // nothing generated yet
+}
+
+//------------------------------------------------------------------
+// position the stream so that the next rng_Uniform returns draw number "draw"
+//------------------------------------------------------------------
+RNG_HD inline void rng_Seek(philox_Stream &s, unsigned long long draw)
+{
+    s.ctr[0] = (uint32_t)(draw / 4);
+    philox4x32_10(s.ctr, s.key, s.block);
+    s.ctr[0]++;
+    s.used = (int)(draw % 4);
+}
+
+RNG_HD inline uint32_t rng_Next(philox_Stream &s)
+{
+    if (s.used == 4)
+    {
+        philox4x32_10(s.ctr, s.key, s.block);
+        s.ctr[0]++;
+        s.used = 0;
+    }
+    return s.block[s.used++];
+}
+
+// Generate a random number between 0 and 1
+RNG_HD inline float rng_Uniform(philox_Stream &s)
+{
+    return rng_To_Float(rng_Next(s));
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Reference values of the SERCA model (see serca_Model.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "serca_Model.h"
+
+serca_Model inesi_Model()
+{
+    serca_Model model;
+    model.topology    = TOPOLOGY_INESI;
+    model.dt          = 1e-7;    // fixed time step
+    model.Ca_sr_conc  = 1.3e-3;  // needs citation
+    model.MgATP_conc  = 5e-3;    // needs citation
+    model.MgADP_conc  = 36e-6;   // needs citation
+    model.Pi_conc     = 1e-3;    // needs citation
+
+    rate_Set &k = model.rates;
+    k[K_S0_S1]   = 4e7;    // Transition rate of  E to E.Ca                       Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S1_S0]   = 4.5e2;  // Transition rate of  E.Ca to E                       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S1_S2]   = 120;    // Transition rate of  E.Ca to E'.Ca                   Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S2_S1]   = 25;     // Transition rate of  E'.Ca to E.Ca                   Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S2_S3]   = 1e8;    // Transition rate of  E'.Ca to E'.Ca2                 Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S3_S2]   = 16;     // Transition rate of  E'.Ca2 to E'.Ca                 Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S3_S4]   = 6e7;    // Transition rate of  E'.Ca2 to E'.ATP.Ca2            Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S4_S3]   = 30;     // Transition rate of  E'.ATP.Ca2 to E'.Ca2            Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S4_S5]   = 200;    // Transition rate of  E'.ATP.Ca2 to E'~P.ADP.Ca2      Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S5_S4]   = 350;    // Transition rate of  E'~P.ADP.Ca2 to E'.ATP.Ca2      Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S5_S6a]  = 800;    // Transition rate of  E'~P.ADP.Ca2 to *E'-P.ADP.Ca2   Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S6a_S5]  = 200;    // Transition rate of *E'-P.ADP.Ca2 to E'~P.ADP.Ca2    Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S6a_S7]  = 500;    // Transition rate of *E'-P.ADP.Ca2 to *E'-P.Ca2       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S7_S6a]  = 4e6;    // Transition rate of *E'-P.Ca2 to *E'.ADP-P.Ca2       Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S5_S6]   = 6;      // Transition rate of *E'~P.ADP.Ca2 to E'~P.Ca2        Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S6_S5]   = 1.25e3; // Transition rate of  E'~P.Ca2 to *E'~P.ADP.Ca2       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S6_S7]   = 1;      // Transition rate of  E'~P.Ca2 to *E'-P.Ca2           Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S7_S6]   = 10;     // Transition rate of *E'-P.Ca2 to E'~P.Ca2            Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S7_S8]   = 500;    // Transition rate of *E'-P.Ca2 to *E-P.Ca2            Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S8_S7]   = 5e5;    // Transition rate of *E-P.Ca2 to *E'-P.Ca2            Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S8_S9]   = 20;     // Transition rate of *E-P.Ca2 to *E-P.Ca              Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S9_S8]   = 20;     // Transition rate of *E-P.Ca to *E-P.Ca2              Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S9_S10]  = 6e2;    // Transition rate of *E-P.Ca to *E-P                  Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S10_S9]  = 6e4;    // Transition rate of *E-P to *E-P.Ca                  Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S10_S11] = 60;     // Transition rate of *E-P to *E-Pi                    Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S11_S10] = 60;     // Transition rate of *E-Pi to *E-P                    Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S11_S0]  = 6e2;    // Transition rate of *E-Pi to E                       Units (s^-1)      Inesi Methods in Enzymology (1988) 157:154-190
+    k[K_S0_S11]  = 1.5e4;  // Transition rate of  E to *E-Pi                      Units (M^-1 s^-1) Inesi Methods in Enzymology (1988) 157:154-190
+    return model;
+}
+
+const char *rate_Name(int i)
+{
+    static const char *names[n_Rates] = {
+        "k_S0_S1",   "k_S0_S11",
+        "k_S1_S2",   "k_S1_S0",
+        "k_S2_S3",   "k_S2_S1",
+        "k_S3_S4",   "k_S3_S2",
+        "k_S4_S5",   "k_S4_S3",
+        "k_S5_S6a",  "k_S5_S4",
+        "k_S5_S6",   "k_S6_S5",
+        "k_S6a_S7",  "k_S6a_S5",
+        "k_S7_S8",   "k_S7_S6a",
+        "k_S7_S6",   "k_S6_S7",
+        "k_S8_S9",   "k_S8_S7",
+        "k_S9_S10",  "k_S9_S8",
+        "k_S10_S11", "k_S10_S9",
+        "k_S11_S0",  "k_S11_S10" };
+    return (i >= 0 && i < n_Rates) ? names[i] : "";
+}
+
+bool parse_Topology(const char *name, model_Topology &topology)
+{
+    if      (strcmp(name, "inesi") == 0) topology = TOPOLOGY_INESI;
+    else if (strcmp(name, "no-s6") == 0) topology = TOPOLOGY_NO_S6;
+    else return false;
+    return true;
+}
+
+const char *topology_Name(model_Topology topology)
+{
+    return (topology == TOPOLOGY_NO_S6) ? "no-s6 (S5 -> S6 -> S7 path dropped)" : "inesi";
+}
@@ -0,0 +1,67 @@
+/*-----------------------------------------------------------------------------------------------------
+// The parameters of one SERCA model: the 28 transition rates, the fixed concentrations and dt.
+//
+// rate_Set keeps the rates in one contiguous, aligned array indexed by rate_Index (named after the
+// transitions, K_S0_S1 = k.S0.S1 etc.), so a model is a plain value: it is copied per particle, passed by
+// const reference, and the kernels read it without aliasing concerns. The cytosolic Ca concentration is
+// not part of the model, it is the variable of the pCa curve.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef SERCA_MODEL_H
+#define SERCA_MODEL_H
+
+enum rate_Index
+{
+    K_S0_S1,   K_S0_S11,
+    K_S1_S2,   K_S1_S0,
+    K_S2_S3,   K_S2_S1,
+    K_S3_S4,   K_S3_S2,
+    K_S4_S5,   K_S4_S3,
+    K_S5_S6a,  K_S5_S4,
+    K_S5_S6,   K_S6_S5,
+    K_S6a_S7,  K_S6a_S5,
+    K_S7_S8,   K_S7_S6a,
+    K_S7_S6,   K_S6_S7,
+    K_S8_S9,   K_S8_S7,
+    K_S9_S10,  K_S9_S8,
+    K_S10_S11, K_S10_S9,
+    K_S11_S0,  K_S11_S10,
+    n_Rates
+};
+
+// which transitions the scheme has (the edge tables are in update_States.cpp)
+enum model_Topology
+{
+    TOPOLOGY_INESI = 0, // the full 13-state scheme
+    TOPOLOGY_NO_S6      // without the S5 -> S6 -> S7 side path
+};
+
+struct rate_Set
+{
+    alignas(32) float k[n_Rates];
+
+    float &operator[](int i)       { return k[i]; }
+    float  operator[](int i) const { return k[i]; }
+};
+
+struct serca_Model
+{
+    rate_Set rates;
+    float    Ca_sr_conc; // SR lumen Ca (M)
+    float    Pi_conc;    // (M)
+    float    MgATP_conc; // (M)
+    float    MgADP_conc; // (M)
+    float    dt;         // fixed time step (s)
+    model_Topology topology; // which edge table build_Transition_Table uses
+};
+
+// the reference model: Inesi, Methods in Enzymology (1988) 157:154-190, dt = 1e-7 s
+serca_Model inesi_Model();
+
+// "k_S0_S1", ... for output files and command lines
+const char *rate_Name(int i);
+
+bool           parse_Topology(const char *name, model_Topology &topology); // "inesi", "no-s6"; false if unknown
+const char    *topology_Name (model_Topology topology);
+
+#endif
@@ -0,0 +1,54 @@
+/*-----------------------------------------------------------------------------------------------------
+// How get_Residual and lastRun obtain the steady-state occupancy of the 13 SERCA states.
+//
+//      ENGINE_FIXED_DT  : fixed-dt Monte Carlo time marching (update_States / simd_Engine)
+//      ENGINE_GILLESPIE : exact stochastic simulation, waiting times sampled directly (gillespie_Engine)
+//      ENGINE_CME       : master equation averaged over the steady-state window, no sampling (cme_Engine)
+//      ENGINE_CME_SS    : t -> infinity steady state of the master equation, one LU solve (cme_Engine)
+//      ENGINE_GPU       : the fixed-dt engine on a GPU, same streams and results (gpu_Engine.h; for now the CPU)
+//      ENGINE_POPULATION: the fixed-dt chain as 13 state counts, multinomial jumps between samples (population_Engine)
+//
+// All engines use the same transition_Table, so they simulate the same scheme with the same rates.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef SIM_ENGINE_H
+#define SIM_ENGINE_H
+
+#include <string.h>
+
+enum sim_Engine { ENGINE_FIXED_DT = 0, ENGINE_GILLESPIE, ENGINE_CME, ENGINE_CME_SS, ENGINE_GPU, ENGINE_POPULATION };
+
+// "fixed" (default), "gillespie", "cme", "cme-ss", "gpu", "population" (or "tau"); false if unknown
+inline bool parse_Sim_Engine(const char *name, sim_Engine &engine)
+{
+    if      (strcmp(name, "fixed")      == 0) engine = ENGINE_FIXED_DT;
+    else if (strcmp(name, "gillespie")  == 0) engine = ENGINE_GILLESPIE;
+    else if (strcmp(name, "cme")        == 0) engine = ENGINE_CME;
+    else if (strcmp(name, "cme-ss")     == 0) engine = ENGINE_CME_SS;
+    else if (strcmp(name, "gpu")        == 0) engine = ENGINE_GPU;
+    else if (strcmp(name, "population") == 0 || strcmp(name, "tau") == 0) engine = ENGINE_POPULATION;
+    else return false;
+    return true;
+}
+
+inline const char *sim_Engine_Name(sim_Engine engine)
+{
+    switch (engine)
+    {
+        case ENGINE_GILLESPIE: return "gillespie";
+        case ENGINE_CME:       return "cme";
+        case ENGINE_CME_SS:    return "cme-ss";
+        case ENGINE_GPU:       return "gpu";
+        case ENGINE_POPULATION: return "population";
+        default:               return "fixed";
+    }
+}
+
+// the engines whose occupancy carries sampling noise (more molecules = smaller error)
+inline bool engine_Is_Stochastic(sim_Engine engine)
+{
+    return engine == ENGINE_FIXED_DT || engine == ENGINE_GILLESPIE || engine == ENGINE_GPU ||
+           engine == ENGINE_POPULATION;
+}
+
+#endif
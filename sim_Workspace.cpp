@@ -0,0 +1,30 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Per-worker simulation workspaces (see sim_Workspace.h).
+//
+// The workspace of a thread is created by its first worker_Workspace call with the aligned operator new
+// of C++17, so it starts on a cache line of its own; the thread_local owner deletes it when the thread
+// ends (OpenMP keeps its pool threads, and with them their workspaces, for the whole run).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <stddef.h>
+#include "sim_Workspace.h"
+
+struct workspace_Owner
+{
+    sim_Workspace *workspace;
+    workspace_Owner() : workspace(NULL) {}
+    ~workspace_Owner() { delete workspace; }
+};
+
+sim_Workspace &worker_Workspace()
+{
+    static thread_local workspace_Owner owner;
+    if (owner.workspace == NULL) owner.workspace = new sim_Workspace;
+    return *owner.workspace;
+}
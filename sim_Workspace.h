@@ -0,0 +1,58 @@
+/*-----------------------------------------------------------------------------------------------------
+// Per-worker simulation workspaces.
+//
+// A residual evaluation needs scratch memory: the transition tables and accumulators of every data
+// point (get_Residual), the state lanes of the fixed-dt engine (steady_State.cpp) and the buffers of
+// steady-state detection. Instead of variable-length arrays on the stack and vectors built per call,
+// every thread (OpenMP worker, or the single thread of a serial / MPI build) owns one sim_Workspace,
+// allocated the first time it asks for it and reused for all later particles, iterations and pCa
+// points. After that first call the hot path allocates nothing, and threads never share mutable state.
+//
+// Each workspace is one allocation aligned to a cache line, and the groups of members written in the
+// inner loops start on a line of their own: two threads never write the same line (no false sharing),
+// and the lanes start on a boundary the AVX2 / AVX-512 kernels like. The vectors only grow (--ss-detect
+// with more molecules, get_Residual_Swarm with more models) and keep their capacity.
+//
+// The members belong to one caller at a time: get_Residual / get_Residual_Swarm use the curve members
+// and the engines use the lanes and detection buffers; neither calls into the other's members.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef SIM_WORKSPACE_H
+#define SIM_WORKSPACE_H
+
+#include <stdint.h>
+#include <vector>
+#include "update_States.h"
+#include "steady_State.h"
+#include "exp_Data.h"
+
+const int cache_Line = 64; // bytes
+
+struct sim_Workspace
+{
+    // fixed-dt engine: one block of molecules per pCa point of a fused sweep (fixed_Dt_Accumulate uses [0])
+    alignas(cache_Line) uint8_t states[max_Sweep][molecule_Block];
+    std::vector<uint8_t> detect_states;  // --ss-detect: all molecules of a call
+    std::vector<double>  detect_means;   // ... and its block averages, n_States each
+    unsigned int sweep_streams[max_Data_Points]; // engine_Accumulate_Sweep, one GPU launch per curve
+    int          sweep_pCa[max_Data_Points];
+
+    // get_Residual: one entry per data point
+    alignas(cache_Line) transition_Table tables[max_Data_Points];
+    ss_Accumulator acc[max_Data_Points];       // all molecules so far
+    ss_Accumulator acc_batch[max_Data_Points]; // the current batch
+    float          bound[max_Data_Points];       // observable of all molecules so far
+    float          batch_bound[max_Data_Points]; // ... of the current batch
+    data_Kind      kind[max_Data_Points];
+
+    // get_Residual_Swarm: n_models x n_points of each
+    std::vector<transition_Table> swarm_tables;
+    std::vector<ss_Accumulator>   swarm_acc;
+    std::vector<unsigned int>     swarm_streams;
+    std::vector<int>              swarm_pCa;
+};
+
+// the calling thread's workspace (allocated on its first call, freed when the thread ends)
+sim_Workspace &worker_Workspace();
+
+#endif
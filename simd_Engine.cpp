@@ -0,0 +1,537 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Vectorized Monte Carlo stepping of SERCA molecules (see simd_Engine.h).
+//
+// Every vector lane is one molecule. For each group of four time steps the lanes generate one Philox
+// block (four uniform random numbers per lane) with vector multiplies. Each step then looks up
+// the three thresholds and the three destinations of the current state of every lane. The 13-state
+// table is small enough to live in registers, so the lookup is a register gather (vpermps /
+// vpermd) instead of a memory gather. The transition is resolved with compares and blends:
+//
+//      next = u < p0 ? to0 : u < p1 ? to1 : u < p2 ? to2 : state
+//
+// The fused sweep (advance_States_Fused) reuses each random block for the copies of the same molecule
+// at all pCa points, so the Philox cost is paid once instead of n_pCa times.
+//
+// The AVX2 and AVX-512 kernels are compiled with target attributes, so the rest of the program
+// does not need -mavx2 and the binary still runs (scalar) on older CPUs.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include "rng_Philox.h"
+#include "simd_Engine.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized" // false positive on _mm512_undefined_* inside the gcc 12 intrinsics
+#endif
+#endif
+
+//------------------------------------------------------------------
+// row-major transition table repacked column-wise, padded to 16 states
+//------------------------------------------------------------------
+struct packed_Table
+{
+    float p [max_Branch][16];
+    int   to[max_Branch][16];
+};
+
+static void pack_Table(const transition_Table &table, packed_Table &pack)
+{
+    memset(&pack, 0, sizeof(pack));
+    for (int s = 0; s < n_States; s++)
+    {
+        for (int k = 0; k < max_Branch; k++)
+        {
+            pack.p [k][s] = table.p[s][k];
+            pack.to[k][s] = table.next[s][k];
+        }
+    }
+}
+
+//------------------------------------------------------------------
+// scalar path: one molecule at a time through update_States
+//------------------------------------------------------------------
+static void advance_Scalar(const transition_Table &table,
+                           unsigned long long seed, unsigned int stream_id, int pCa,
+                           uint8_t *states, int first_molecule, int n_molecules,
+                           int step_begin, int step_end)
+{
+    for (int j = 0; j < n_molecules; j++)
+    {
+        philox_Stream rng;
+        rng_Init(rng, seed, stream_id, pCa, first_molecule + j);
+        rng_Seek(rng, step_begin);
+        int state = states[j];
+        for (int n = step_begin; n < step_end; n++)
+        {
+            update_States(state, rng_Uniform(rng), table);
+        }
+        states[j] = (uint8_t)state;
+    }
+}
+
+
+//------------------------------------------------------------------
+// scalar fused sweep: every draw of a molecule moves its copy at every pCa point
+//------------------------------------------------------------------
+static void advance_Fused_Scalar(const transition_Table *tables, int n_pCa,
+                                 unsigned long long seed, unsigned int stream_id,
+                                 uint8_t *states, int stride, int first_molecule, int n_molecules,
+                                 int step_begin, int step_end)
+{
+    for (int j = 0; j < n_molecules; j++)
+    {
+        philox_Stream rng;
+        rng_Init(rng, seed, stream_id, rng_ALL_PCA, first_molecule + j);
+        rng_Seek(rng, step_begin);
+        int state[max_Sweep];
+        for (int c = 0; c < n_pCa; c++) state[c] = states[c * stride + j];
+        for (int n = step_begin; n < step_end; n++)
+        {
+            float u = rng_Uniform(rng);
+            for (int c = 0; c < n_pCa; c++)
+            {
+                update_States(state[c], u, tables[c]);
+            }
+        }
+        for (int c = 0; c < n_pCa; c++) states[c * stride + j] = (uint8_t)state[c];
+    }
+}
+
+#ifdef SIMD_X86
+const uint32_t PHILOX_M0 = 0xD2511F53u, PHILOX_M1 = 0xCD9E8D57u;
+const uint32_t PHILOX_W0 = 0x9E3779B9u, PHILOX_W1 = 0xBB67AE85u;
+
+//==================================================================
+//                         AVX2 :  8 lanes
+//==================================================================
+__attribute__((target("avx2")))
+static inline void mulhilo_AVX2(__m256i a, __m256i m, __m256i &hi, __m256i &lo)
+{
+    lo = _mm256_mullo_epi32(a, m);
+    __m256i even = _mm256_mul_epu32(a, m);                         // 64-bit products of lanes 0,2,4,6
+    __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);  // 64-bit products of lanes 1,3,5,7
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+__attribute__((target("avx2")))
+static inline void philox_AVX2(uint32_t block, __m256i molecule, uint32_t pCa, uint32_t stream_id,
+                               uint32_t k0, uint32_t k1, __m256 u[4])
+{
+    const __m256i M0 = _mm256_set1_epi32((int)PHILOX_M0), M1 = _mm256_set1_epi32((int)PHILOX_M1);
+    __m256i c0 = _mm256_set1_epi32((int)block), c1 = molecule;
+    __m256i c2 = _mm256_set1_epi32((int)pCa),   c3 = _mm256_set1_epi32((int)stream_id);
+    for (int r = 0; r < 10; r++)
+    {
+        __m256i hi0, lo0, hi1, lo1;
+        mulhilo_AVX2(c0, M0, hi0, lo0);
+        mulhilo_AVX2(c2, M1, hi1, lo1);
+        c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32((int)k0));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32((int)k1));
+        c3 = lo0;
+        k0 += PHILOX_W0; k1 += PHILOX_W1;
+    }
+    const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+    u[0] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c0, 8)), scale);
+    u[1] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c1, 8)), scale);
+    u[2] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c2, 8)), scale);
+    u[3] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c3, 8)), scale);
+}
+
+struct table_AVX2
+{
+    __m256 p_lo[max_Branch], p_hi[max_Branch];   // states 0-7 and 8-15
+    __m256i to_lo[max_Branch], to_hi[max_Branch];
+};
+
+__attribute__((target("avx2")))
+static inline __m256i step_AVX2(__m256i s, __m256 u, const table_AVX2 &t)
+{
+    __m256i upper = _mm256_cmpgt_epi32(s, _mm256_set1_epi32(7));
+    __m256  upper_ps = _mm256_castsi256_ps(upper);
+    __m256i r = s;
+    for (int k = max_Branch - 1; k >= 0; k--) // innermost bucket first so that the lowest one wins
+    {
+        __m256  p  = _mm256_blendv_ps(_mm256_permutevar8x32_ps(t.p_lo[k], s), _mm256_permutevar8x32_ps(t.p_hi[k], s), upper_ps);
+        __m256i to = _mm256_blendv_epi8(_mm256_permutevar8x32_epi32(t.to_lo[k], s), _mm256_permutevar8x32_epi32(t.to_hi[k], s), upper);
+        __m256i lt = _mm256_castps_si256(_mm256_cmp_ps(u, p, _CMP_LT_OQ));
+        r = _mm256_blendv_epi8(r, to, lt);
+    }
+    return r;
+}
+
+__attribute__((target("avx2")))
+static int advance_AVX2(const packed_Table &pack,
+                        unsigned long long seed, unsigned int stream_id, int pCa,
+                        uint8_t *states, int first_molecule, int n_molecules,
+                        int step_begin, int step_end)
+{
+    table_AVX2 t;
+    for (int k = 0; k < max_Branch; k++)
+    {
+        t.p_lo [k] = _mm256_loadu_ps(pack.p[k]);
+        t.p_hi [k] = _mm256_loadu_ps(pack.p[k] + 8);
+        t.to_lo[k] = _mm256_loadu_si256((const __m256i *)pack.to[k]);
+        t.to_hi[k] = _mm256_loadu_si256((const __m256i *)(pack.to[k] + 8));
+    }
+    const uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    const int n_vec = n_molecules / 8 * 8;
+    for (int j = 0; j < n_vec; j += 8)
+    {
+        __m256i s   = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(states + j)));
+        __m256i mol = _mm256_add_epi32(_mm256_set1_epi32(first_molecule + j), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256  u[4];
+        int n = step_begin;
+        while (n < step_end)
+        {
+            philox_AVX2((uint32_t)(n / 4), mol, (uint32_t)pCa, stream_id, k0, k1, u);
+            if ((n & 3) == 0 && n + 4 <= step_end)
+            {
+                s = step_AVX2(s, u[0], t);
+                s = step_AVX2(s, u[1], t);
+                s = step_AVX2(s, u[2], t);
+                s = step_AVX2(s, u[3], t);
+                n += 4;
+            }
+            else
+            {
+                for (int w = n & 3; w < 4 && n < step_end; w++, n++)
+                {
+                    s = step_AVX2(s, u[w], t);
+                }
+            }
+        }
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256((__m256i *)lanes, s);
+        for (int l = 0; l < 8; l++)
+        {
+            states[j + l] = (uint8_t)lanes[l];
+        }
+    }
+    return n_vec;
+}
+
+__attribute__((target("avx2")))
+static int advance_Fused_AVX2(const packed_Table *packs, int n_pCa,
+                              unsigned long long seed, unsigned int stream_id,
+                              uint8_t *states, int stride, int first_molecule, int n_molecules,
+                              int step_begin, int step_end)
+{
+    table_AVX2 t[max_Sweep];
+    for (int c = 0; c < n_pCa; c++)
+    {
+        for (int k = 0; k < max_Branch; k++)
+        {
+            t[c].p_lo [k] = _mm256_loadu_ps(packs[c].p[k]);
+            t[c].p_hi [k] = _mm256_loadu_ps(packs[c].p[k] + 8);
+            t[c].to_lo[k] = _mm256_loadu_si256((const __m256i *)packs[c].to[k]);
+            t[c].to_hi[k] = _mm256_loadu_si256((const __m256i *)(packs[c].to[k] + 8));
+        }
+    }
+    const uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    const int n_vec = n_molecules / 8 * 8;
+    for (int j = 0; j < n_vec; j += 8)
+    {
+        __m256i s[max_Sweep];
+        for (int c = 0; c < n_pCa; c++)
+        {
+            s[c] = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(states + c * stride + j)));
+        }
+        __m256i mol = _mm256_add_epi32(_mm256_set1_epi32(first_molecule + j), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        __m256  u[4];
+        int n = step_begin;
+        while (n < step_end)
+        {
+            philox_AVX2((uint32_t)(n / 4), mol, rng_ALL_PCA, stream_id, k0, k1, u);
+            int w_begin = n & 3;
+            int w_end   = (step_end - n < 4 - w_begin) ? w_begin + (step_end - n) : 4;
+            for (int c = 0; c < n_pCa; c++) // one random block drives all pCa points
+            {
+                for (int w = w_begin; w < w_end; w++)
+                {
+                    s[c] = step_AVX2(s[c], u[w], t[c]);
+                }
+            }
+            n += w_end - w_begin;
+        }
+        for (int c = 0; c < n_pCa; c++)
+        {
+            alignas(32) int32_t lanes[8];
+            _mm256_store_si256((__m256i *)lanes, s[c]);
+            for (int l = 0; l < 8; l++)
+            {
+                states[c * stride + j + l] = (uint8_t)lanes[l];
+            }
+        }
+    }
+    return n_vec;
+}
+
+//==================================================================
+//                        AVX-512 : 16 lanes
+//==================================================================
+__attribute__((target("avx512f")))
+static inline void mulhilo_AVX512(__m512i a, __m512i m, __m512i &hi, __m512i &lo)
+{
+    lo = _mm512_mullo_epi32(a, m);
+    __m512i even = _mm512_mul_epu32(a, m);
+    __m512i odd  = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), m);
+    hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+}
+
+__attribute__((target("avx512f")))
+static inline void philox_AVX512(uint32_t block, __m512i molecule, uint32_t pCa, uint32_t stream_id,
+                                 uint32_t k0, uint32_t k1, __m512 u[4])
+{
+    const __m512i M0 = _mm512_set1_epi32((int)PHILOX_M0), M1 = _mm512_set1_epi32((int)PHILOX_M1);
+    __m512i c0 = _mm512_set1_epi32((int)block), c1 = molecule;
+    __m512i c2 = _mm512_set1_epi32((int)pCa),   c3 = _mm512_set1_epi32((int)stream_id);
+    for (int r = 0; r < 10; r++)
+    {
+        __m512i hi0, lo0, hi1, lo1;
+        mulhilo_AVX512(c0, M0, hi0, lo0);
+        mulhilo_AVX512(c2, M1, hi1, lo1);
+        c0 = _mm512_xor_si512(_mm512_xor_si512(hi1, c1), _mm512_set1_epi32((int)k0));
+        c1 = lo1;
+        c2 = _mm512_xor_si512(_mm512_xor_si512(hi0, c3), _mm512_set1_epi32((int)k1));
+        c3 = lo0;
+        k0 += PHILOX_W0; k1 += PHILOX_W1;
+    }
+    const __m512 scale = _mm512_set1_ps(1.0f / 16777216.0f);
+    u[0] = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(c0, 8)), scale);
+    u[1] = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(c1, 8)), scale);
+    u[2] = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(c2, 8)), scale);
+    u[3] = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(c3, 8)), scale);
+}
+
+struct table_AVX512
+{
+    __m512  p [max_Branch];
+    __m512i to[max_Branch];
+};
+
+__attribute__((target("avx512f")))
+static inline __m512i step_AVX512(__m512i s, __m512 u, const table_AVX512 &t)
+{
+    __m512i r = s;
+    for (int k = max_Branch - 1; k >= 0; k--)
+    {
+        __mmask16 lt = _mm512_cmp_ps_mask(u, _mm512_permutexvar_ps(s, t.p[k]), _CMP_LT_OQ);
+        r = _mm512_mask_blend_epi32(lt, r, _mm512_permutexvar_epi32(s, t.to[k]));
+    }
+    return r;
+}
+
+__attribute__((target("avx512f")))
+static int advance_AVX512(const packed_Table &pack,
+                          unsigned long long seed, unsigned int stream_id, int pCa,
+                          uint8_t *states, int first_molecule, int n_molecules,
+                          int step_begin, int step_end)
+{
+    table_AVX512 t;
+    for (int k = 0; k < max_Branch; k++)
+    {
+        t.p [k] = _mm512_loadu_ps(pack.p[k]);
+        t.to[k] = _mm512_loadu_si512(pack.to[k]);
+    }
+    const uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    const int n_vec = n_molecules / 16 * 16;
+    for (int j = 0; j < n_vec; j += 16)
+    {
+        __m512i s   = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(states + j)));
+        __m512i mol = _mm512_add_epi32(_mm512_set1_epi32(first_molecule + j),
+                                       _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        __m512  u[4];
+        int n = step_begin;
+        while (n < step_end)
+        {
+            philox_AVX512((uint32_t)(n / 4), mol, (uint32_t)pCa, stream_id, k0, k1, u);
+            if ((n & 3) == 0 && n + 4 <= step_end)
+            {
+                s = step_AVX512(s, u[0], t);
+                s = step_AVX512(s, u[1], t);
+                s = step_AVX512(s, u[2], t);
+                s = step_AVX512(s, u[3], t);
+                n += 4;
+            }
+            else
+            {
+                for (int w = n & 3; w < 4 && n < step_end; w++, n++)
+                {
+                    s = step_AVX512(s, u[w], t);
+                }
+            }
+        }
+        _mm_storeu_si128((__m128i *)(states + j), _mm512_cvtepi32_epi8(s));
+    }
+    return n_vec;
+}
+
+__attribute__((target("avx512f")))
+static int advance_Fused_AVX512(const packed_Table *packs, int n_pCa,
+                                unsigned long long seed, unsigned int stream_id,
+                                uint8_t *states, int stride, int first_molecule, int n_molecules,
+                                int step_begin, int step_end)
+{
+    table_AVX512 t[max_Sweep];
+    for (int c = 0; c < n_pCa; c++)
+    {
+        for (int k = 0; k < max_Branch; k++)
+        {
+            t[c].p [k] = _mm512_loadu_ps(packs[c].p[k]);
+            t[c].to[k] = _mm512_loadu_si512(packs[c].to[k]);
+        }
+    }
+    const uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    const int n_vec = n_molecules / 16 * 16;
+    for (int j = 0; j < n_vec; j += 16)
+    {
+        __m512i s[max_Sweep];
+        for (int c = 0; c < n_pCa; c++)
+        {
+            s[c] = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *)(states + c * stride + j)));
+        }
+        __m512i mol = _mm512_add_epi32(_mm512_set1_epi32(first_molecule + j),
+                                       _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+        __m512  u[4];
+        int n = step_begin;
+        while (n < step_end)
+        {
+            philox_AVX512((uint32_t)(n / 4), mol, rng_ALL_PCA, stream_id, k0, k1, u);
+            int w_begin = n & 3;
+            int w_end   = (step_end - n < 4 - w_begin) ? w_begin + (step_end - n) : 4;
+            for (int c = 0; c < n_pCa; c++) // one random block drives all pCa points
+            {
+                if (w_begin == 0 && w_end == 4)
+                {
+                    s[c] = step_AVX512(s[c], u[0], t[c]);
+                    s[c] = step_AVX512(s[c], u[1], t[c]);
+                    s[c] = step_AVX512(s[c], u[2], t[c]);
+                    s[c] = step_AVX512(s[c], u[3], t[c]);
+                }
+                else
+                {
+                    for (int w = w_begin; w < w_end; w++)
+                    {
+                        s[c] = step_AVX512(s[c], u[w], t[c]);
+                    }
+                }
+            }
+            n += w_end - w_begin;
+        }
+        for (int c = 0; c < n_pCa; c++)
+        {
+            _mm_storeu_si128((__m128i *)(states + c * stride + j), _mm512_cvtepi32_epi8(s[c]));
+        }
+    }
+    return n_vec;
+}
+#endif // SIMD_X86
+
+//--------------------------------------------------------------------------//
+
+simd_Level resolve_Simd_Level(simd_Level requested)
+{
+    bool has_avx2 = false, has_avx512 = false;
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    has_avx2   = __builtin_cpu_supports("avx2");
+    has_avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    if (requested == SIMD_AUTO)                  requested = SIMD_AVX512;
+    if (requested == SIMD_AVX512 && !has_avx512) requested = SIMD_AVX2;
+    if (requested == SIMD_AVX2   && !has_avx2)   requested = SIMD_SCALAR;
+    return requested;
+}
+
+bool parse_Simd_Level(const char *name, simd_Level &level)
+{
+    if      (strcmp(name, "auto")   == 0) level = SIMD_AUTO;
+    else if (strcmp(name, "scalar") == 0) level = SIMD_SCALAR;
+    else if (strcmp(name, "avx2")   == 0) level = SIMD_AVX2;
+    else if (strcmp(name, "avx512") == 0) level = SIMD_AVX512;
+    else return false;
+    return true;
+}
+
+const char *simd_Level_Name(simd_Level level)
+{
+    switch (level)
+    {
+        case SIMD_SCALAR: return "scalar";
+        case SIMD_AVX2:   return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default:          return "auto";
+    }
+}
+
+void advance_States(simd_Level level, const transition_Table &table,
+                    unsigned long long seed, unsigned int stream_id, int pCa,
+                    uint8_t *states, int first_molecule, int n_molecules,
+                    int step_begin, int step_end)
+{
+    int done = 0; // molecules handled by the vector kernel, the rest goes through the scalar path
+#ifdef SIMD_X86
+    level = resolve_Simd_Level(level);
+    if (level != SIMD_SCALAR)
+    {
+        packed_Table pack;
+        pack_Table(table, pack);
+        if (level == SIMD_AVX512)
+        {
+            done = advance_AVX512(pack, seed, stream_id, pCa, states, first_molecule, n_molecules, step_begin, step_end);
+        }
+        else
+        {
+            done = advance_AVX2(pack, seed, stream_id, pCa, states, first_molecule, n_molecules, step_begin, step_end);
+        }
+    }
+#endif
+    advance_Scalar(table, seed, stream_id, pCa, states + done, first_molecule + done, n_molecules - done, step_begin, step_end);
+}
+
+void advance_States_Fused(simd_Level level, const transition_Table *tables, int n_pCa,
+                          unsigned long long seed, unsigned int stream_id,
+                          uint8_t *states, int stride, int first_molecule, int n_molecules,
+                          int step_begin, int step_end)
+{
+    if (n_pCa > max_Sweep) // more points than the kernels hold: one ordinary pass per point
+    {
+        for (int c = 0; c < n_pCa; c++)
+        {
+            advance_States(level, tables[c], seed, stream_id, rng_ALL_PCA, states + c * stride,
+                           first_molecule, n_molecules, step_begin, step_end);
+        }
+        return;
+    }
+    int done = 0;
+#ifdef SIMD_X86
+    level = resolve_Simd_Level(level);
+    if (level != SIMD_SCALAR)
+    {
+        packed_Table packs[max_Sweep];
+        for (int c = 0; c < n_pCa; c++)
+        {
+            pack_Table(tables[c], packs[c]);
+        }
+        if (level == SIMD_AVX512)
+        {
+            done = advance_Fused_AVX512(packs, n_pCa, seed, stream_id, states, stride, first_molecule, n_molecules, step_begin, step_end);
+        }
+        else
+        {
+            done = advance_Fused_AVX2(packs, n_pCa, seed, stream_id, states, stride, first_molecule, n_molecules, step_begin, step_end);
+        }
+    }
+#endif
+    advance_Fused_Scalar(tables, n_pCa, seed, stream_id, states + done, stride, first_molecule + done, n_molecules - done, step_begin, step_end);
+}
@@ -0,0 +1,47 @@
+/*-----------------------------------------------------------------------------------------------------
+// Batched stepping of many independent SERCA molecules.
+//
+// The molecule states are kept as a structure-of-arrays lane vector (one uint8_t per molecule).
+// advance_States moves molecules [first_molecule, first_molecule + n_molecules) forward over the
+// time steps [step_begin, step_end). Molecule rr uses draw number n of its Philox stream
+// (stream_id, pCa, rr) at time step n. That is the same draw the scalar update_States path sees,
+// so every level below produces bit-identical trajectories.
+//
+//      SIMD_SCALAR : one molecule at a time (update_States)
+//      SIMD_AVX2   :  8 molecules per instruction
+//      SIMD_AVX512 : 16 molecules per instruction
+//
+// SIMD_AUTO picks the widest level the CPU supports at runtime.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef SIMD_ENGINE_H
+#define SIMD_ENGINE_H
+
+#include <stdint.h>
+#include "update_States.h"
+
+enum simd_Level { SIMD_AUTO = 0, SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512 };
+
+simd_Level  resolve_Simd_Level(simd_Level requested); // AUTO -> best supported; unsupported -> next lower level
+bool        parse_Simd_Level  (const char *name, simd_Level &level); // "auto", "scalar", "avx2", "avx512"; false if unknown
+const char *simd_Level_Name   (simd_Level level);
+
+void advance_States(simd_Level level, const transition_Table &table,
+                    unsigned long long seed, unsigned int stream_id, int pCa,
+                    uint8_t *states, int first_molecule, int n_molecules,
+                    int step_begin, int step_end);
+
+//------------------------------------------------------------------
+// fused pCa sweep: the same molecules simulated at n_pCa concentrations at once. Molecule rr has one
+// random stream (stream_id, rng_ALL_PCA, rr) whose draw n moves its copy at every pCa point at step n
+// (common random numbers across the curve). states[c * stride + j] is molecule first_molecule + j at
+// pCa point c, moved with tables[c].
+//------------------------------------------------------------------
+const int max_Sweep = 32; // pCa points one fused kernel holds
+
+void advance_States_Fused(simd_Level level, const transition_Table *tables, int n_pCa,
+                          unsigned long long seed, unsigned int stream_id,
+                          uint8_t *states, int stride, int first_molecule, int n_molecules,
+                          int step_begin, int step_end);
+
+#endif
@@ -0,0 +1,335 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Steady-state window, accumulator and engine dispatch (see steady_State.h).
+//
+// The fixed-dt engine marches the molecules in blocks of molecule_Block: all molecules of a block go
+// from one sample point to the next together (advance_States), the block's states are counted at each
+// sample point inside the window, and the block accumulator is merged into the total. The state vector
+// of one block stays in L1, and nothing is stored per time step. The fused sweep does the same with one
+// state vector per pCa point, all moved by the same random numbers. Steady-state detection moves all
+// molecules of a call together instead (one byte each), since it watches their aggregate occupancy.
+// The state vectors and the detection buffers are those of the thread's workspace (sim_Workspace.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <vector>
+#include "steady_State.h"
+#include "sim_Workspace.h"
+#include "gillespie_Engine.h"
+#include "cme_Engine.h"
+#include "population_Engine.h"
+#include "gpu_Engine.h"
+#include "rng_Philox.h"
+#include "perf_Counters.h"
+
+const int   detect_Blocks  = 8;    // block averages of the steady state before the run may stop
+const float detect_Z       = 3.0f; // sampling noise allowed on top of drift_tol, in standard deviations
+
+ss_Window make_Window(int max_tsteps, int window_steps, int stride)
+{
+    ss_Window window;
+    window.end    = max_tsteps - 1;
+    window.begin  = max_tsteps - window_steps;
+    if (window.begin < 0) window.begin = 0;
+    window.stride = (stride > 0) ? stride : 1;
+    window.detect    = false;
+    window.block     = 5;
+    window.drift_tol = 0.02f;
+    window.n_eff     = 1.0f;
+    return window;
+}
+
+void enable_Detection(ss_Window &window, int block, float drift_tol, float n_eff)
+{
+    window.detect = true;
+    if (block     > 1) window.block     = block;
+    if (drift_tol > 0) window.drift_tol = drift_tol;
+    if (n_eff     > 0) window.n_eff     = n_eff;
+}
+
+// --ss-detect: samples after every window.stride steps, in blocks of window.block samples (see steady_State.h).
+// Block b is compared with block b/2, i.e. the drift over the second half of the time marched so far,
+// so a slow relaxation is not mistaken for a steady state because neighbouring blocks look alike.
+static void fixed_Dt_Detect(simd_Level simd, const transition_Table &table,
+                            unsigned long long seed, unsigned int stream_id, int pCa,
+                            int first_molecule, int n_molecules, const ss_Window &window,
+                            ss_Accumulator &acc)
+{
+    if (n_molecules <= 0) return;
+    sim_Workspace &ws = worker_Workspace();
+    std::vector<uint8_t> &states = ws.detect_states;
+    std::vector<double>  &means  = ws.detect_means; // block averages, n_States each
+    states.assign(n_molecules, 0);                   // every SERCA starts in state 0
+    means.clear();
+    ss_Accumulator window_acc, steady, block;    // fixed window (fallback), since relaxation, this block
+    ss_Clear(window_acc);
+    ss_Clear(steady);
+    ss_Clear(block);
+    const double per_block = (double)window.block * n_molecules; // molecule-samples of one block
+    int relaxed_at = -1; // first block of the steady state
+    int n_done     = 0;
+    for (int to = window.stride; to <= window.end; to += window.stride)
+    {
+        PERF_COUNT_STEPS((table, seed, stream_id, pCa, &states[0], first_molecule, n_molecules, n_done, to));
+        {
+            PERF_TIMER(KERNEL_FIXED_DT);
+            advance_States(simd, table, seed, stream_id, pCa, &states[0], first_molecule, n_molecules, n_done, to);
+        }
+        PERF_ADD(rng_draws, (long long)(to - n_done) * n_molecules);
+        n_done = to;
+        {
+            PERF_TIMER(KERNEL_BINNING);
+            ss_Add_States(block, &states[0], n_molecules);
+            if (to - 1 >= window.begin) ss_Add_States(window_acc, &states[0], n_molecules);
+        }
+        PERF_ADD(acc_updates, n_molecules);
+        if (block.n_samples < per_block) continue;
+
+        // a block is complete: relaxed yet, and if so, enough effective samples?
+        int b = (int)(means.size() / n_States);
+        for (int s = 0; s < n_States; s++) means.push_back(block.count[s] / block.n_samples);
+        const double *mean = &means[b * n_States];
+        if (relaxed_at < 0 && b >= 2)
+        {
+            const double *earlier = &means[(b / 2) * n_States];
+            bool flat = true;
+            for (int s = 0; s < n_States && flat; s++)
+            {
+                double p     = 0.5 * (mean[s] + earlier[s]);
+                double noise = sqrt(2.0 * p * (1.0 - p) / per_block);
+                flat = fabs(mean[s] - earlier[s]) <= window.drift_tol * fmax(mean[s], earlier[s]) + detect_Z * noise;
+            }
+            if (flat)
+            {
+                relaxed_at = b / 2; // the second half was already flat: its blocks count too
+                for (int r = relaxed_at; r < b; r++)
+                {
+                    for (int s = 0; s < n_States; s++) steady.count[s] += means[r * n_States + s] * per_block;
+                    steady.n_samples += per_block;
+                }
+            }
+        }
+        if (relaxed_at >= 0)
+        {
+            ss_Merge(steady, block);
+            int n_blocks = b + 1 - relaxed_at;
+            if (n_blocks >= detect_Blocks)
+            {
+                // statistical inefficiency of the worst state: variance of its block averages against
+                // that of independent samples
+                double g = 1.0;
+                for (int s = 0; s < n_States; s++)
+                {
+                    double p = steady.count[s] / steady.n_samples;
+                    if (p <= 0.0 || p >= 1.0) continue;
+                    double var = 0.0;
+                    for (int r = relaxed_at; r <= b; r++) var += (means[r * n_States + s] - p) * (means[r * n_States + s] - p);
+                    var /= (n_blocks - 1);
+                    double g_s = per_block * var / (p * (1.0 - p));
+                    if (g_s > g) g = g_s;
+                }
+                if (steady.n_samples / g >= window.n_eff * n_molecules) break;
+            }
+        }
+        ss_Clear(block);
+    }
+    ss_Merge(acc, (relaxed_at >= 0) ? steady : window_acc);
+}
+
+int first_Sample(const ss_Window &window)
+{
+    int first_sample = window.end - 1;
+    if (first_sample >= window.begin)
+    {
+        first_sample -= (first_sample - window.begin) / window.stride * window.stride;
+    }
+    return first_sample;
+}
+
+void fixed_Dt_Accumulate(simd_Level simd, const transition_Table &table,
+                         unsigned long long seed, unsigned int stream_id, int pCa,
+                         int first_molecule, int n_molecules, const ss_Window &window,
+                         ss_Accumulator &acc)
+{
+    if (window.detect)
+    {
+        fixed_Dt_Detect(simd, table, seed, stream_id, pCa, first_molecule, n_molecules, window, acc);
+        return;
+    }
+    int first_sample = first_Sample(window);
+
+    uint8_t *states = worker_Workspace().states[0];
+    int last_molecule = first_molecule + n_molecules;
+    for (int first = first_molecule; first < last_molecule; first += molecule_Block)
+    {
+        int n_block = (last_molecule - first < molecule_Block) ? last_molecule - first : molecule_Block;
+        for (int rr = 0; rr < n_block; rr++)
+        {
+            states[rr] = 0; // every SERCA starts in state 0
+        }
+        ss_Accumulator block;
+        ss_Clear(block);
+        int n_done = 0; // time steps already taken
+        for (int n = first_sample; n < window.end; n += window.stride)
+        {
+            // the sample at step n is the state after the update of step n
+            PERF_COUNT_STEPS((table, seed, stream_id, pCa, states, first, n_block, n_done, n + 1));
+            {
+                PERF_TIMER(KERNEL_FIXED_DT);
+                advance_States(simd, table, seed, stream_id, pCa, states, first, n_block, n_done, n + 1);
+            }
+            PERF_ADD(rng_draws, (long long)(n + 1 - n_done) * n_block);
+            n_done = n + 1;
+            {
+                PERF_TIMER(KERNEL_BINNING);
+                ss_Add_States(block, states, n_block);
+            }
+            PERF_ADD(acc_updates, n_block);
+        }
+        ss_Merge(acc, block);
+    }
+}
+
+void fixed_Dt_Accumulate_Fused(simd_Level simd, const transition_Table *tables, int n_pCa,
+                               unsigned long long seed, unsigned int stream_id,
+                               int first_molecule, int n_molecules, const ss_Window &window,
+                               ss_Accumulator acc[])
+{
+    if (n_pCa > max_Sweep) // more points than one block holds: split the curve
+    {
+        for (int c = 0; c < n_pCa; c += max_Sweep)
+        {
+            int n_part = (n_pCa - c < max_Sweep) ? n_pCa - c : max_Sweep;
+            fixed_Dt_Accumulate_Fused(simd, tables + c, n_part, seed, stream_id, first_molecule, n_molecules, window, acc + c);
+        }
+        return;
+    }
+    int first_sample = first_Sample(window);
+
+    uint8_t (*states)[molecule_Block] = worker_Workspace().states;
+    int last_molecule = first_molecule + n_molecules;
+    for (int first = first_molecule; first < last_molecule; first += molecule_Block)
+    {
+        int n_block = (last_molecule - first < molecule_Block) ? last_molecule - first : molecule_Block;
+        ss_Accumulator block[max_Sweep];
+        for (int c = 0; c < n_pCa; c++)
+        {
+            for (int rr = 0; rr < n_block; rr++)
+            {
+                states[c][rr] = 0;
+            }
+            ss_Clear(block[c]);
+        }
+        int n_done = 0;
+        for (int n = first_sample; n < window.end; n += window.stride)
+        {
+            for (int c = 0; c < n_pCa; c++)
+            {
+                PERF_COUNT_STEPS((tables[c], seed, stream_id, rng_ALL_PCA, states[c], first, n_block, n_done, n + 1));
+            }
+            {
+                PERF_TIMER(KERNEL_FUSED);
+                advance_States_Fused(simd, tables, n_pCa, seed, stream_id, &states[0][0], molecule_Block,
+                                     first, n_block, n_done, n + 1);
+            }
+            PERF_ADD(rng_draws, (long long)(n + 1 - n_done) * n_block); // one draw for all pCa points
+            n_done = n + 1;
+            PERF_TIMER(KERNEL_BINNING);
+            for (int c = 0; c < n_pCa; c++)
+            {
+                ss_Add_States(block[c], states[c], n_block);
+            }
+            PERF_ADD(acc_updates, (long long)n_pCa * n_block);
+        }
+        for (int c = 0; c < n_pCa; c++)
+        {
+            ss_Merge(acc[c], block[c]);
+        }
+    }
+}
+
+void engine_Accumulate(sim_Engine engine, simd_Level simd, const transition_Table &table, float dt,
+                       unsigned long long seed, unsigned int stream_id, int pCa,
+                       int first_molecule, int n_molecules, const ss_Window &window,
+                       ss_Accumulator &acc)
+{
+    double t_begin = window.begin * (double)dt;
+    double t_end   = window.end   * (double)dt;
+    float  occupancy[n_States];
+    switch (engine)
+    {
+        case ENGINE_GILLESPIE:
+            gillespie_Accumulate(table, dt, seed, stream_id, pCa, first_molecule, n_molecules, t_begin, t_end, acc);
+            return;
+        case ENGINE_CME:
+        {
+            PERF_TIMER(KERNEL_CME);
+            cme_Window_Average(table, dt, t_begin, t_end, occupancy);
+            break;
+        }
+        case ENGINE_CME_SS:
+        {
+            PERF_TIMER(KERNEL_CME);
+            cme_Steady_State(table, dt, occupancy);
+            break;
+        }
+        case ENGINE_POPULATION:
+            population_Accumulate(table, seed, stream_id, pCa, first_molecule, n_molecules, window, acc);
+            return;
+        case ENGINE_GPU:
+            if (!window.detect && gpu_Accumulate(&table, 1, &stream_id, &pCa, seed, first_molecule, n_molecules, window, &acc)) return;
+            // fall through - no device: the same molecules on the CPU
+        default:
+            fixed_Dt_Accumulate(simd, table, seed, stream_id, pCa, first_molecule, n_molecules, window, acc);
+            return;
+    }
+    // deterministic engines: the exact occupancy, weighted like n_molecules samples
+    for (int s = 0; s < n_States; s++)
+    {
+        acc.count[s] += (double)occupancy[s] * n_molecules;
+    }
+    acc.n_samples += n_molecules;
+}
+
+void engine_Occupancy(sim_Engine engine, simd_Level simd, const transition_Table &table, float dt,
+                      unsigned long long seed, unsigned int stream_id, int pCa,
+                      int n_molecules, const ss_Window &window,
+                      float occupancy[n_States])
+{
+    ss_Accumulator acc;
+    ss_Clear(acc);
+    engine_Accumulate(engine, simd, table, dt, seed, stream_id, pCa, 0, n_molecules, window, acc);
+    ss_Occupancy(acc, occupancy);
+}
+
+void engine_Accumulate_Sweep(const sim_Config &config, const transition_Table *tables, int n_pCa, float dt,
+                             unsigned long long seed, unsigned int stream_id,
+                             int first_molecule, int n_molecules, ss_Accumulator acc[])
+{
+    if (config.fused_pCa && config.engine == ENGINE_FIXED_DT && !config.window.detect)
+    {
+        fixed_Dt_Accumulate_Fused(config.simd, tables, n_pCa, seed, stream_id, first_molecule, n_molecules, config.window, acc);
+        return;
+    }
+    if (config.engine == ENGINE_GPU && !config.window.detect && n_pCa > 0 && n_pCa <= max_Data_Points) // the whole curve in one launch
+    {
+        sim_Workspace &ws = worker_Workspace();
+        unsigned int *stream_ids = ws.sweep_streams;
+        int          *pCa        = ws.sweep_pCa;
+        for (int c = 0; c < n_pCa; c++)
+        {
+            stream_ids[c] = stream_id;
+            pCa[c]        = c;
+        }
+        if (gpu_Accumulate(tables, n_pCa, stream_ids, pCa, seed, first_molecule, n_molecules, config.window, acc)) return;
+    }
+    for (int c = 0; c < n_pCa; c++)
+    {
+        engine_Accumulate(config.engine, config.simd, tables[c], dt, seed, stream_id, c, first_molecule, n_molecules, config.window, acc[c]);
+    }
+}
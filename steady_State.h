@@ -0,0 +1,132 @@
+/*-----------------------------------------------------------------------------------------------------
+// Steady-state occupancy of the 13 SERCA states, whatever engine produces it.
+//
+// ss_Window says which part of the simulated time counts as steady state: the time steps [begin, end).
+// The fixed-dt engine samples the states of all molecules every "stride" steps inside the window,
+// counting back from the last step (end - 1, end - 1 - stride, ...), and adds each sample into an
+// ss_Accumulator: one counter per state, independent of max_tsteps. The Gillespie and CME engines use the
+// same window as a time interval [begin * dt, end * dt).
+//
+// With window.detect (--ss-detect, fixed-dt) the window finds itself for every call: the molecules of
+// the call are marched together and their occupancy vector is averaged over blocks of window.block
+// samples. Once the block average of every state has changed by less than a fraction drift_tol over the
+// second half of the time marched so far (beyond the sampling noise), the chain is taken as relaxed and
+// the samples of that half and later count. The run stops once the block averages give n_eff effective
+// samples per molecule (the statistical inefficiency is estimated from the spread of the block
+// averages). end is then only the longest horizon; if the chain has not relaxed by then, the samples of
+// [begin, end) are used as without detection. A slow drift only shows above the noise with enough
+// molecules per call (thousands; not the small batches of --adaptive).
+//
+// engine_Accumulate runs the selected engine for one Ca_cyt_conc (one transition_Table) and adds the
+// molecules it simulated to an accumulator; ss_Occupancy then gives the fraction of molecules in every
+// state, averaged over the window. The Gillespie engine adds time-weighted fractions instead of counts.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include <stdint.h>
+#include "update_States.h"
+#include "simd_Engine.h"
+#include "sim_Engine.h"
+
+const int molecule_Block = 1024; // molecules marched together by the fixed-dt engine
+
+struct ss_Window
+{
+    int   begin;     // first time step inside the window
+    int   end;       // one past the last time step inside the window
+    int   stride;    // fixed-dt: sample every stride steps
+    bool  detect;    // find the window from the drift of the occupancy (fixed-dt)
+    int   block;     // samples per block average
+    float drift_tol; // largest relative change of a state's block average at steady state
+    float n_eff;     // effective samples per molecule to stop at
+};
+
+// the last window_steps of max_tsteps (historically 10000; the very last step is left out), no detection
+ss_Window make_Window(int max_tsteps, int window_steps, int stride);
+
+// window.detect on, with block, drift_tol and n_eff (defaults for values <= 0)
+void enable_Detection(ss_Window &window, int block, float drift_tol, float n_eff);
+
+// first fixed-dt sample point: the last step of the window, stepped back by whole strides
+int first_Sample(const ss_Window &window);
+
+// how the curves are simulated (get_Residual, lastRun); the points come from the data (exp_Data.h)
+struct sim_Config
+{
+    int        n_molecules; // SERCA molecules per pCa point
+    int        max_tsteps;  // time steps of one run (the time axis is max_tsteps * dt)
+    ss_Window  window;      // steady-state window; window.stride is the sample stride
+    sim_Engine engine;
+    simd_Level simd;
+    bool       fused_pCa;   // fixed-dt: one random stream per molecule for the whole curve
+    bool       verbose;     // get_Residual prints every residual (main: --verbosity 1)
+};
+
+struct ss_Accumulator
+{
+    double count[n_States]; // molecule-samples seen in each state
+    double n_samples;       // molecule-samples in total
+};
+
+inline void ss_Clear(ss_Accumulator &acc)
+{
+    for (int s = 0; s < n_States; s++) acc.count[s] = 0.0;
+    acc.n_samples = 0.0;
+}
+
+inline void ss_Add_States(ss_Accumulator &acc, const uint8_t *states, int n_molecules)
+{
+    for (int rr = 0; rr < n_molecules; rr++)
+    {
+        acc.count[states[rr]] += 1.0;
+    }
+    acc.n_samples += n_molecules;
+}
+
+inline void ss_Merge(ss_Accumulator &into, const ss_Accumulator &from)
+{
+    for (int s = 0; s < n_States; s++) into.count[s] += from.count[s];
+    into.n_samples += from.n_samples;
+}
+
+inline void ss_Occupancy(const ss_Accumulator &acc, float occupancy[n_States])
+{
+    for (int s = 0; s < n_States; s++)
+    {
+        occupancy[s] = (acc.n_samples > 0) ? (float)(acc.count[s] / acc.n_samples) : 0.0f;
+    }
+}
+
+// the engines add molecules [first_molecule, first_molecule + n_molecules) to acc, so a run can be split
+// into batches (the molecule streams do not depend on the batching)
+void fixed_Dt_Accumulate(simd_Level simd, const transition_Table &table,
+                         unsigned long long seed, unsigned int stream_id, int pCa,
+                         int first_molecule, int n_molecules, const ss_Window &window,
+                         ss_Accumulator &acc);
+
+void engine_Accumulate(sim_Engine engine, simd_Level simd, const transition_Table &table, float dt,
+                       unsigned long long seed, unsigned int stream_id, int pCa,
+                       int first_molecule, int n_molecules, const ss_Window &window,
+                       ss_Accumulator &acc);
+
+// the whole pCa curve (n_pCa points), acc[c] for tables[c]. config.fused_pCa (fixed-dt only): one random stream per molecule drives
+// its copies at all pCa points (advance_States_Fused), otherwise every point has its own streams (pCa = c)
+// and this is engine_Accumulate once per point
+void fixed_Dt_Accumulate_Fused(simd_Level simd, const transition_Table *tables, int n_pCa,
+                               unsigned long long seed, unsigned int stream_id,
+                               int first_molecule, int n_molecules, const ss_Window &window,
+                               ss_Accumulator acc[]);
+
+void engine_Accumulate_Sweep(const sim_Config &config, const transition_Table *tables, int n_pCa, float dt,
+                             unsigned long long seed, unsigned int stream_id,
+                             int first_molecule, int n_molecules, ss_Accumulator acc[]);
+
+// all molecules 0 ... n_molecules-1 in one go
+void engine_Occupancy(sim_Engine engine, simd_Level simd, const transition_Table &table, float dt,
+                      unsigned long long seed, unsigned int stream_id, int pCa,
+                      int n_molecules, const ss_Window &window,
+                      float occupancy[n_States]);
+
+#endif
@@ -0,0 +1,150 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Local Gaussian-process surrogate of the residual (see surrogate.h).
+//
+// A global GP over the whole archive would cost O(N^3) with N up to (max_iter+2) x particles points;
+// the local fit costs one O(N) distance scan and one n_neighbours^3 Cholesky factorisation per
+// prediction.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <math.h>
+#include <utility>
+#include <algorithm>
+#include "surrogate.h"
+
+using namespace std;
+
+const float surrogate_Nugget = 0.01f; // Monte Carlo noise variance / signal variance
+
+void surrogate_Init(surrogate_Model &model, int n_dim, const float *lower, const float *upper,
+                    int n_neighbours, float kappa)
+{
+    model.enabled      = true;
+    model.n_dim        = (n_dim < max_Surrogate_Dim) ? n_dim : max_Surrogate_Dim;
+    model.n_neighbours = (n_neighbours > 2) ? n_neighbours : 2;
+    model.kappa        = kappa;
+    model.nugget       = surrogate_Nugget;
+    for (int k = 0; k < model.n_dim; k++)
+    {
+        model.lower[k] = lower[k];
+        model.scale[k] = (upper[k] > lower[k]) ? 1.0f / (upper[k] - lower[k]) : 1.0f;
+    }
+    surrogate_Clear(model);
+}
+
+void surrogate_Clear(surrogate_Model &model)
+{
+    model.x.clear();
+    model.y.clear();
+}
+
+void surrogate_Add(surrogate_Model &model, const float *position, float residual)
+{
+    if (!(residual < HUGE_VALF)) return; // nothing to learn from a failed evaluation
+    for (int k = 0; k < model.n_dim; k++) model.x.push_back((position[k] - model.lower[k]) * model.scale[k]);
+    model.y.push_back(residual);
+}
+
+bool surrogate_Predict(const surrogate_Model &model, const float *position, float &mean, float &sigma)
+{
+    const int d = model.n_dim;
+    const int n_points = (int)model.y.size();
+    const int m = model.n_neighbours;
+    if (n_points < m) return false;
+
+    double u[max_Surrogate_Dim];
+    for (int k = 0; k < d; k++) u[k] = (position[k] - model.lower[k]) * model.scale[k];
+
+    // the m nearest archived points
+    vector< pair<double, int> > dist(n_points);
+    for (int j = 0; j < n_points; j++)
+    {
+        double r2 = 0.0;
+        for (int k = 0; k < d; k++)
+        {
+            double t = u[k] - model.x[j * d + k];
+            r2 += t * t;
+        }
+        dist[j] = make_pair(r2, j);
+    }
+    partial_sort(dist.begin(), dist.begin() + m, dist.end());
+
+    double y_mean = 0.0, length = 0.0;
+    for (int a = 0; a < m; a++)
+    {
+        y_mean += model.y[dist[a].second];
+        length += sqrt(dist[a].first);
+    }
+    y_mean /= m;
+    length /= m;
+    double variance = 0.0;
+    for (int a = 0; a < m; a++)
+    {
+        double t = model.y[dist[a].second] - y_mean;
+        variance += t * t;
+    }
+    variance /= m;
+    if (length < 1e-6) length = 1e-6;
+    if (variance < 1e-20) variance = 1e-20;
+    const double inv_2l2 = 0.5 / (length * length);
+
+    // K = variance * exp(-r^2 / 2 l^2) + nugget * variance * I, Cholesky K = L L^T
+    vector<double> L((size_t)m * m, 0.0), k_star(m), alpha(m), v(m);
+    for (int a = 0; a < m; a++)
+    {
+        const float *xa = &model.x[dist[a].second * d];
+        for (int b = 0; b <= a; b++)
+        {
+            const float *xb = &model.x[dist[b].second * d];
+            double r2 = 0.0;
+            for (int k = 0; k < d; k++) r2 += (double)(xa[k] - xb[k]) * (xa[k] - xb[k]);
+            L[a * m + b] = variance * exp(-r2 * inv_2l2) + (a == b ? model.nugget * variance : 0.0);
+        }
+        k_star[a] = variance * exp(-dist[a].first * inv_2l2);
+    }
+    for (int j = 0; j < m; j++)
+    {
+        double sum = L[j * m + j];
+        for (int k = 0; k < j; k++) sum -= L[j * m + k] * L[j * m + k];
+        if (sum <= 0.0) return false; // not positive definite (duplicate points without noise)
+        L[j * m + j] = sqrt(sum);
+        for (int i = j + 1; i < m; i++)
+        {
+            double s = L[i * m + j];
+            for (int k = 0; k < j; k++) s -= L[i * m + k] * L[j * m + k];
+            L[i * m + j] = s / L[j * m + j];
+        }
+    }
+    // alpha = K^-1 (y - y_mean), v = L^-1 k_star
+    for (int i = 0; i < m; i++)
+    {
+        double s = model.y[dist[i].second] - y_mean, t = k_star[i];
+        for (int k = 0; k < i; k++)
+        {
+            s -= L[i * m + k] * alpha[k];
+            t -= L[i * m + k] * v[k];
+        }
+        alpha[i] = s / L[i * m + i];
+        v[i]     = t / L[i * m + i];
+    }
+    for (int i = m - 1; i >= 0; i--)
+    {
+        double s = alpha[i];
+        for (int k = i + 1; k < m; k++) s -= L[k * m + i] * alpha[k];
+        alpha[i] = s / L[i * m + i];
+    }
+    double f = y_mean, var = variance;
+    for (int a = 0; a < m; a++)
+    {
+        f   += k_star[a] * alpha[a];
+        var -= v[a] * v[a];
+    }
+    mean  = (float)f;
+    sigma = (float)sqrt(var > 0.0 ? var : 0.0);
+    return true;
+}
@@ -0,0 +1,48 @@
+/*-----------------------------------------------------------------------------------------------------
+// Surrogate pre-screening of the swarm (--surrogate).
+//
+// Late in a run most particle moves do not improve their pbest, yet each costs a full get_Residual.
+// The surrogate keeps every (position, residual) pair the swarm has evaluated and predicts the residual
+// of a new position with a Gaussian process fitted to its n_neighbours nearest archived points (squared
+// exponential kernel; length scale = mean distance to those neighbours, signal variance = variance of
+// their residuals, a nugget of nugget x that variance for the Monte Carlo noise). With the prediction
+// mean +- sigma a particle is only simulated if
+//
+//      mean - kappa * sigma <= its pbest residual
+//
+// i.e. if it may move its pbest (promising: low mean, or uncertain: large sigma); the others keep the
+// predicted mean as their residual, which by construction does not change pbest or gbest.
+//
+// Positions are scaled by the bounds of the swarm (the coordinates are (x - lower) / (upper - lower)),
+// so all rates count alike. The archive holds residuals of one fidelity level; surrogate_Clear starts
+// a new one. Screening is deterministic, so every MPI rank takes the same decisions.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#include <vector>
+
+const int max_Surrogate_Dim = 16;
+
+struct surrogate_Model
+{
+    bool               enabled;
+    int                n_dim;
+    int                n_neighbours; // points of the local fit (--surrogate-neighbours)
+    float              kappa;        // confidence multiplier (--surrogate-kappa)
+    float              nugget;       // noise variance, relative to the signal variance
+    float              lower[max_Surrogate_Dim], scale[max_Surrogate_Dim];
+    std::vector<float> x;            // archive: n_dim scaled coordinates per point
+    std::vector<float> y;            // ... and its residual
+};
+
+void surrogate_Init (surrogate_Model &model, int n_dim, const float *lower, const float *upper,
+                     int n_neighbours, float kappa);
+void surrogate_Clear(surrogate_Model &model);
+void surrogate_Add  (surrogate_Model &model, const float *position, float residual);
+
+// false while the archive has fewer than n_neighbours points (no prediction: simulate)
+bool surrogate_Predict(const surrogate_Model &model, const float *position, float &mean, float &sigma);
+
+#endif
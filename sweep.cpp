@@ -0,0 +1,448 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Sweep driver (make sweep / sweep_omp / sweep_hybrid; ./sweep CONDITIONS [options]).
+//
+// Fits the four PSO rates (k_S0_S1, k_S2_S3, k_S7_S8, k_S9_S10) for every experimental condition of a list
+// in one run. Every condition has its own swarm, but the swarms advance together: the evaluations of one
+// iteration of all conditions (n_conditions x particles) form one work list. The list is dealt out over the
+// MPI ranks and spread dynamically over the OpenMP threads, and all of it goes through one residual cache
+// (--cache; the cache key includes the condition). A short or cheap condition therefore does not leave
+// cores idle, and one allocation runs all conditions where each used to be its own job.
+//
+// CONDITIONS has one condition per line, "#" starts a comment. A line is a list of key=value fields:
+//      name=NAME                             (required) label in the output
+//      ca=FILE  ca_weight=W                  Ca curve (default exp_Calcium.dat)
+//      pi=FILE  pi_weight=W  pi_ca=CA        Pi curve, fitted if given, at cytosolic Ca CA (default 1e-9 M)
+//      MgATP=C  MgADP=C  Pi=C  Ca_sr=C       concentrations (M); the others keep the Inesi values
+//      topology=inesi|no-s6
+// e.g.   name=low_atp  MgATP=1e-3  ca=exp_Calcium_low_ATP.dat      (sweep_Conditions.dat is an example)
+//
+// The PSO is the one of main.cpp (bounds 0.1x ... 10x the Inesi rates, inertia 0.3 -> 1, c1 = c2 = 1.05,
+// pbest racing with --adaptive). Its random numbers come from a Philox stream per condition, so all ranks
+// draw the same swarm without a broadcast. Particle i of iteration it uses stream (it+1) * particles + i
+// in every condition.
+//
+// Output: sweep_history.csv (gbest of every condition after every iteration, appended) and
+//         sweep_results.csv  (the best rates of every condition).
+//
+// usage: ./sweep CONDITIONS [--seed S] [--particles P] [--iterations N] [--molecules M] [--engine E]
+//                [--simd L] [--ss-window W] [--ss-stride S] [--ss-detect] [--fused-pca] [--adaptive]
+//                [--adaptive-batch B] [--cache RES] [--cache-max N] [--verbosity 0|1]
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+#include "rng_Philox.h"
+#include "get_Residual.h"
+#include "residual_Cache.h"
+#include "gpu_Engine.h"
+
+using namespace std;
+
+const int      sweep_Rate[4]    = { K_S0_S1, K_S2_S3, K_S7_S8, K_S9_S10 }; // the fitted rates
+const uint32_t sweep_PSO_Stream = 0xFFFFFFFEu; // stream id of the PSO draws (pCa index = condition)
+
+int id = 0, p = 1; // MPI rank and size
+
+//------------------------------------------------------------------
+// one line of the condition list: plain data, read on rank 0 and broadcast as bytes
+//------------------------------------------------------------------
+struct sweep_Spec
+{
+    char        name[64];
+    serca_Model model; // the Inesi model with the condition's concentrations
+    exp_Data    data;
+};
+
+struct sweep_Swarm
+{
+    philox_Stream rng; // PSO random numbers of this condition
+    vector<float> X[4], V[4], pbest[4];
+    vector<float> Res_pbest, residual;
+    float         gbest[4], Res_gbest;
+};
+
+//------------------------------------------------------------------
+// parses CONDITIONS; false with a message in error
+//------------------------------------------------------------------
+static bool read_Conditions(const char *file, vector<sweep_Spec> &specs, string &error)
+{
+    ifstream in(file);
+    if (!in.is_open())
+    {
+        error = string("cannot open ") + file;
+        return false;
+    }
+    string line;
+    for (int n_line = 1; getline(in, line); n_line++)
+    {
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+        istringstream fields(line);
+        string field;
+        if (!(fields >> field)) continue; // empty line
+
+        sweep_Spec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.model = inesi_Model();
+        string name, ca_file = "exp_Calcium.dat", pi_file;
+        float  ca_weight = 1.0f, pi_weight = 1.0f, pi_Ca_cyt = 1e-9f;
+        do
+        {
+            size_t eq = field.find('=');
+            string key   = field.substr(0, eq);
+            string value = (eq == string::npos) ? "" : field.substr(eq + 1);
+            if (eq == string::npos || value.empty())
+            {
+                error = string(file) + ", line " + to_string(n_line) + ": expected key=value, got " + field;
+                return false;
+            }
+            if      (key == "name")      name                   = value;
+            else if (key == "ca")        ca_file                = value;
+            else if (key == "pi")        pi_file                = value;
+            else if (key == "ca_weight") ca_weight              = atof(value.c_str());
+            else if (key == "pi_weight") pi_weight              = atof(value.c_str());
+            else if (key == "pi_ca")     pi_Ca_cyt              = atof(value.c_str());
+            else if (key == "MgATP")     spec.model.MgATP_conc  = atof(value.c_str());
+            else if (key == "MgADP")     spec.model.MgADP_conc  = atof(value.c_str());
+            else if (key == "Pi")        spec.model.Pi_conc     = atof(value.c_str());
+            else if (key == "Ca_sr")     spec.model.Ca_sr_conc  = atof(value.c_str());
+            else if (key == "topology")
+            {
+                if (!parse_Topology(value.c_str(), spec.model.topology))
+                {
+                    error = string(file) + ", line " + to_string(n_line) + ": unknown topology " + value + " (inesi | no-s6)";
+                    return false;
+                }
+            }
+            else
+            {
+                error = string(file) + ", line " + to_string(n_line) + ": unknown key " + key;
+                return false;
+            }
+        } while (fields >> field);
+        if (name.empty() || name.size() >= sizeof(spec.name))
+        {
+            error = string(file) + ", line " + to_string(n_line) + ": every condition needs a name (up to 63 characters)";
+            return false;
+        }
+        strcpy(spec.name, name.c_str());
+        exp_Clear(spec.data);
+        if (!load_Dataset(spec.data, ca_file.c_str(), DATA_CALCIUM, ca_weight, 0.0f, error) ||
+            (!pi_file.empty() && !load_Dataset(spec.data, pi_file.c_str(), DATA_PHOSPHATE, pi_weight, pi_Ca_cyt, error)))
+        {
+            error = name + ": " + error;
+            return false;
+        }
+        specs.push_back(spec);
+    }
+    if (specs.empty()) error = string(file) + " lists no condition";
+    return !specs.empty();
+}
+
+static float pso_Uniform(sweep_Swarm &swarm)
+{
+    return rng_Uniform(swarm.rng);
+}
+
+//------------------------------------------------------------------
+// the residuals of all particles of all conditions at their current positions: one work list of
+// specs.size() x n_particles evaluations, round-robin over the ranks, dynamic over the threads
+//------------------------------------------------------------------
+static void evaluate_All(const vector<sweep_Spec> &specs, vector<sweep_Swarm> &swarms, int n_particles,
+                         residual_Cache &cache, const sim_Config &config, const adaptive_Config &adaptive,
+                         unsigned long long seed, unsigned int first_stream, bool race_pbest,
+                         long long &molecules)
+{
+    const int n_jobs = (int)specs.size() * n_particles;
+    vector<float> residual(n_jobs, 0.0f);
+    vector<int>   used(n_jobs, 0);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int job = id; job < n_jobs; job += p)
+    {
+        const int c = job / n_particles, i = job % n_particles;
+        serca_Model particle = specs[c].model;
+        for (int k = 0; k < 4; k++) particle.rates[sweep_Rate[k]] = swarms[c].X[k][i];
+        float prune_above = race_pbest ? swarms[c].Res_pbest[i] : HUGE_VALF;
+        residual[job] = cached_Residual(cache, particle, config, specs[c].data, seed, first_stream + i,
+                                        adaptive, prune_above, used[job]);
+    }
+#ifdef USE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &residual[0], n_jobs, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &used[0],     n_jobs, MPI_INT,   MPI_SUM, MPI_COMM_WORLD);
+#endif
+    for (int job = 0; job < n_jobs; job++)
+    {
+        swarms[job / n_particles].residual[job % n_particles] = residual[job];
+        molecules += used[job];
+    }
+}
+
+//------------------------------------------------------------------
+// pbest / gbest of one condition after an evaluation (first: the initial swarm)
+//------------------------------------------------------------------
+static void update_Bests(sweep_Swarm &swarm, int n_particles, bool first)
+{
+    int best = 0;
+    for (int i = 1; i < n_particles; i++)
+    {
+        if (swarm.residual[i] < swarm.residual[best]) best = i;
+    }
+    if (first || swarm.residual[best] <= swarm.Res_gbest)
+    {
+        for (int k = 0; k < 4; k++) swarm.gbest[k] = swarm.X[k][best];
+        swarm.Res_gbest = swarm.residual[best];
+    }
+    for (int i = 0; i < n_particles; i++)
+    {
+        if (first || swarm.residual[i] <= swarm.Res_pbest[i])
+        {
+            for (int k = 0; k < 4; k++) swarm.pbest[k][i] = swarm.X[k][i];
+            swarm.Res_pbest[i] = swarm.residual[i];
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &id);
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+#endif
+    gpu_Select_Device(id);
+    long long startTime = time(NULL);
+    string conditions_file;
+    unsigned long long seed = time(NULL);
+    int    n_particles = 100, max_iter = 100, n_molecules = 10000, max_tsteps = 100001;
+    int    ss_window_steps = 10000, ss_stride = 1000, verbosity = 0;
+    bool   ss_detect = false;
+    float  cache_resolution = 0;
+    long   cache_max = 16384;
+    sim_Config      config;
+    adaptive_Config adaptive = { false, 500, 4, 3.0f, 0.0f };
+    config.engine    = ENGINE_FIXED_DT;
+    config.simd      = SIMD_AUTO;
+    config.fused_pCa = false;
+    string engine_name, simd_name;
+    for (int a = 1; a < argc; a++)
+    {
+        if      (string(argv[a]) == "--seed"           && a+1 < argc) seed             = strtoull(argv[++a], NULL, 10);
+        else if (string(argv[a]) == "--particles"      && a+1 < argc) n_particles      = atoi(argv[++a]);
+        else if (string(argv[a]) == "--iterations"     && a+1 < argc) max_iter         = atoi(argv[++a]);
+        else if (string(argv[a]) == "--molecules"      && a+1 < argc) n_molecules      = atoi(argv[++a]);
+        else if (string(argv[a]) == "--engine"         && a+1 < argc) engine_name      = argv[++a];
+        else if (string(argv[a]) == "--simd"           && a+1 < argc) simd_name        = argv[++a];
+        else if (string(argv[a]) == "--ss-window"      && a+1 < argc) ss_window_steps  = atoi(argv[++a]);
+        else if (string(argv[a]) == "--ss-stride"      && a+1 < argc) ss_stride        = atoi(argv[++a]);
+        else if (string(argv[a]) == "--ss-detect")                    ss_detect        = true;
+        else if (string(argv[a]) == "--fused-pca")                    config.fused_pCa = true;
+        else if (string(argv[a]) == "--adaptive")                     adaptive.enabled = true;
+        else if (string(argv[a]) == "--adaptive-batch" && a+1 < argc) adaptive.batch   = atoi(argv[++a]);
+        else if (string(argv[a]) == "--cache"          && a+1 < argc) cache_resolution = atof(argv[++a]);
+        else if (string(argv[a]) == "--cache-max"      && a+1 < argc) cache_max        = atol(argv[++a]);
+        else if (string(argv[a]) == "--verbosity"      && a+1 < argc) verbosity        = atoi(argv[++a]);
+        else if (argv[a][0] != '-' && conditions_file.empty())        conditions_file  = argv[a];
+    }
+    if (!engine_name.empty() && !parse_Sim_Engine(engine_name.c_str(), config.engine))
+    {
+        if (id == 0) cout << " Simulation engine       : unknown engine " << engine_name
+                          << " (fixed | gillespie | cme | cme-ss | gpu | population)" << endl;
+#ifdef USE_MPI
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+    if (!simd_name.empty() && !parse_Simd_Level(simd_name.c_str(), config.simd))
+    {
+        if (id == 0) cout << " SIMD level              : unknown level " << simd_name << " (auto | scalar | avx2 | avx512)" << endl;
+#ifdef USE_MPI
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+    if (n_particles < 1) n_particles = 1;
+    if (max_iter    < 0) max_iter    = 0;
+    config.n_molecules = n_molecules;
+    config.max_tsteps  = max_tsteps;
+    config.window      = make_Window(max_tsteps, ss_window_steps, ss_stride);
+    if (ss_detect) enable_Detection(config.window, 0, 0.0f, 0.0f);
+    config.simd        = resolve_Simd_Level(config.simd);
+    config.verbose     = verbosity >= 1;
+#ifdef USE_MPI
+    MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+#endif
+
+    //---------------------------------------------------------------------------------
+    // the conditions and their data: parsed on rank 0, the other ranks get a copy
+    //---------------------------------------------------------------------------------
+    vector<sweep_Spec> specs;
+    int n_conditions = 0;
+    if (id == 0)
+    {
+        string error;
+        if (conditions_file.empty()) error = "usage: ./sweep CONDITIONS [options] (see sweep.cpp)";
+        else if (read_Conditions(conditions_file.c_str(), specs, error)) n_conditions = (int)specs.size();
+        if (!error.empty()) cout << " Conditions              : " << error << endl;
+    }
+#ifdef USE_MPI
+    MPI_Bcast(&n_conditions, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    specs.resize(n_conditions);
+    if (n_conditions > 0) MPI_Bcast(&specs[0], n_conditions * sizeof(sweep_Spec), MPI_BYTE, 0, MPI_COMM_WORLD);
+#endif
+    if (n_conditions == 0)
+    {
+#ifdef USE_MPI
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+
+    residual_Cache cache;
+    cache_Init(cache, cache_resolution, cache_max > 0 ? cache_max : 0);
+    if (id == 0)
+    {
+        cout << " Random seed of this run : " << seed << endl;
+        cout << " Simulation engine       : " << sim_Engine_Name(config.engine) << ", " << n_molecules << " molecules" << endl;
+        cout << " Swarms                  : " << n_conditions << " conditions x " << n_particles << " particles, "
+             << max_iter << " iterations" << endl;
+        for (int c = 0; c < n_conditions; c++)
+        {
+            const serca_Model &m = specs[c].model;
+            cout << " Condition " << c << "             : " << specs[c].name << " (MgATP " << m.MgATP_conc << ", MgADP " << m.MgADP_conc
+                 << ", Pi " << m.Pi_conc << ", Ca_sr " << m.Ca_sr_conc << ", " << specs[c].data.n_points << " points)" << endl;
+        }
+        if (cache.enabled) cout << " Residual cache          : bins of " << cache_resolution << " in log10 k, shared by all conditions" << endl;
+    }
+
+    //---------------------------------------------------------------------------------
+    // initial swarms (every rank draws the same numbers)
+    //---------------------------------------------------------------------------------
+    const serca_Model reference = inesi_Model();
+    float lower[4], upper[4];
+    for (int k = 0; k < 4; k++)
+    {
+        lower[k] = 0.1f * reference.rates[sweep_Rate[k]];
+        upper[k] = 10.0f * reference.rates[sweep_Rate[k]];
+    }
+    vector<sweep_Swarm> swarms(n_conditions);
+    for (int c = 0; c < n_conditions; c++)
+    {
+        sweep_Swarm &swarm = swarms[c];
+        rng_Init(swarm.rng, seed, sweep_PSO_Stream, (uint32_t)c, 0);
+        for (int k = 0; k < 4; k++)
+        {
+            swarm.X[k].resize(n_particles);
+            swarm.V[k].resize(n_particles);
+            swarm.pbest[k].resize(n_particles);
+        }
+        swarm.Res_pbest.resize(n_particles);
+        swarm.residual.resize(n_particles);
+        for (int i = 0; i < n_particles; i++)
+        {
+            for (int k = 0; k < 4; k++) swarm.X[k][i] = lower[k] + (upper[k] - lower[k]) * pso_Uniform(swarm);
+            for (int k = 0; k < 4; k++) swarm.V[k][i] = 0.25f * (upper[k] - lower[k]) * pso_Uniform(swarm);
+        }
+    }
+    ofstream history;
+    if (id == 0)
+    {
+        history.open("sweep_history.csv");
+        history << "condition,iteration,Res_gbest";
+        for (int k = 0; k < 4; k++) history << "," << rate_Name(sweep_Rate[k]);
+        history << "\n";
+    }
+    long long molecules = 0;
+    evaluate_All(specs, swarms, n_particles, cache, config, adaptive, seed, 0, false, molecules);
+    for (int c = 0; c < n_conditions; c++) update_Bests(swarms[c], n_particles, true);
+
+    //---------------------------------------------------------------------------------
+    // swarm iterations, all conditions in step
+    //---------------------------------------------------------------------------------
+    const float w_max = 1.0f, w_min = 0.3f, c1 = 1.05f, c2 = 1.05f;
+    const float dw = (max_iter > 0) ? (w_max - w_min) / max_iter : 0.0f;
+    for (int it = 0; it < max_iter + 1 && max_iter > 0; it++)
+    {
+        float w = w_min + it * dw;
+        for (int c = 0; c < n_conditions; c++)
+        {
+            sweep_Swarm &swarm = swarms[c];
+            for (int i = 0; i < n_particles; i++)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    float r1 = pso_Uniform(swarm), r2 = pso_Uniform(swarm);
+                    swarm.V[k][i] = w * swarm.V[k][i] + c1 * r1 * (swarm.pbest[k][i] - swarm.X[k][i])
+                                                      + c2 * r2 * (swarm.gbest[k]    - swarm.X[k][i]);
+                    swarm.X[k][i] = swarm.X[k][i] + swarm.V[k][i];
+                }
+            }
+        }
+        evaluate_All(specs, swarms, n_particles, cache, config, adaptive, seed, (it+1) * n_particles, true, molecules);
+
+        for (int c = 0; c < n_conditions; c++)
+        {
+            update_Bests(swarms[c], n_particles, false);
+            if (id != 0) continue;
+            history << specs[c].name << "," << it << "," << swarms[c].Res_gbest;
+            for (int k = 0; k < 4; k++) history << "," << swarms[c].gbest[k];
+            history << "\n";
+        }
+        if (id == 0)
+        {
+            history.flush();
+            cout << " Iteration " << it << " (" << (time(NULL) - startTime) << " s):";
+            for (int c = 0; c < n_conditions; c++) cout << "  " << specs[c].name << " " << swarms[c].Res_gbest;
+            cout << endl;
+        }
+        if (cache.enabled)
+        {
+            cache_Stats stats = cache_Take_Stats(cache);
+            long long counts[3] = { stats.hits, stats.refined, stats.misses };
+#ifdef USE_MPI
+            MPI_Allreduce(MPI_IN_PLACE, counts, 3, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+#endif
+            if (id == 0) cout << " Residual cache          : " << counts[0] << " hits, " << counts[1] << " refined, "
+                              << counts[2] << " misses" << endl;
+        }
+    }
+
+    if (id == 0)
+    {
+        ofstream results("sweep_results.csv");
+        results << "condition,Res_gbest";
+        for (int k = 0; k < 4; k++) results << "," << rate_Name(sweep_Rate[k]);
+        results << "\n";
+        for (int c = 0; c < n_conditions; c++)
+        {
+            results << specs[c].name << "," << swarms[c].Res_gbest;
+            for (int k = 0; k < 4; k++) results << "," << swarms[c].gbest[k];
+            results << "\n";
+            cout << " " << specs[c].name << " : Res_gbest " << swarms[c].Res_gbest;
+            for (int k = 0; k < 4; k++) cout << ", " << rate_Name(sweep_Rate[k]) << " = " << swarms[c].gbest[k];
+            cout << endl;
+        }
+        cout << " Molecules simulated     : " << molecules << " (per data point)" << endl;
+        cout << "Total Sweep Runtime: " << (time(NULL) - startTime) << " second(s)" << endl;
+    }
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+    return 0;
+}
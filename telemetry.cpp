@@ -0,0 +1,74 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Buffered, append-only CSV log of the particle evaluations (see telemetry.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <time.h>
+#include "telemetry.h"
+
+using namespace std;
+
+double wall_Seconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+bool telemetry_Open(telemetry_Log &log, const char *file, const char *const rate_names[telemetry_Rates], double flush_every)
+{
+    log.file = fopen(file, "a");
+    if (log.file == NULL) return false;
+    log.buffer.clear();
+    log.buffer.reserve(1 << 16);
+    log.flush_every = flush_every;
+    log.last_flush  = wall_Seconds();
+    if (ftell(log.file) == 0) // new file: header
+    {
+        log.buffer += "iteration,particle,rank,thread";
+        for (int k = 0; k < telemetry_Rates; k++)
+        {
+            log.buffer += ',';
+            log.buffer += rate_names[k];
+        }
+        log.buffer += ",residual,molecules,seconds\n";
+    }
+    return true;
+}
+
+void telemetry_Write(telemetry_Log &log, const telemetry_Record &record)
+{
+    if (log.file == NULL) return;
+    char line[256];
+    int n = snprintf(line, sizeof(line), "%d,%d,%d,%d,%.7g,%.7g,%.7g,%.7g,%.7g,%d,%.4f\n",
+                     record.iteration, record.particle, record.rank, record.thread,
+                     record.rates[0], record.rates[1], record.rates[2], record.rates[3],
+                     record.residual, record.molecules, record.seconds);
+    if (n > 0) log.buffer.append(line, n < (int)sizeof(line) ? n : (int)sizeof(line) - 1);
+    if (wall_Seconds() - log.last_flush >= log.flush_every) telemetry_Flush(log);
+}
+
+void telemetry_Flush(telemetry_Log &log)
+{
+    if (log.file == NULL) return;
+    if (!log.buffer.empty())
+    {
+        fwrite(log.buffer.data(), 1, log.buffer.size(), log.file);
+        fflush(log.file);
+        log.buffer.clear();
+    }
+    log.last_flush = wall_Seconds();
+}
+
+void telemetry_Close(telemetry_Log &log)
+{
+    if (log.file == NULL) return;
+    telemetry_Flush(log);
+    fclose(log.file);
+    log.file = NULL;
+}
@@ -0,0 +1,47 @@
+/*-----------------------------------------------------------------------------------------------------
+// Run telemetry (--telemetry FILE).
+//
+// One CSV line per particle evaluation: swarm iteration, particle, MPI rank and OpenMP thread, the
+// fitted rates, residual, molecules per data point and wall time of the evaluation. The lines collect
+// in memory and go to the file in one write once flush_every seconds have passed (and at
+// telemetry_Close), so the swarm loop does not wait for a shared filesystem. The file is appended to:
+// a resumed run (--resume) continues the log of the interrupted one.
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdio.h>
+#include <string>
+
+const int telemetry_Rates = 4; // the fitted rates of a particle
+
+struct telemetry_Record
+{
+    int    iteration; // -1: the initial swarm
+    int    particle;
+    int    rank, thread;
+    float  rates[telemetry_Rates];
+    float  residual;
+    int    molecules; // per data point (fewer than n_SERCA_Molecules if pruned by --adaptive)
+    double seconds;   // wall time of the evaluation
+};
+
+struct telemetry_Log
+{
+    FILE       *file;        // NULL: telemetry off
+    std::string buffer;      // lines not written yet
+    double      flush_every; // seconds between writes
+    double      last_flush;
+};
+
+// wall clock in seconds (monotonic, for timing evaluations)
+double wall_Seconds();
+
+// rate_names: header of the rate columns; false if file cannot be opened
+bool telemetry_Open (telemetry_Log &log, const char *file, const char *const rate_names[telemetry_Rates], double flush_every);
+void telemetry_Write(telemetry_Log &log, const telemetry_Record &record);
+void telemetry_Flush(telemetry_Log &log);
+void telemetry_Close(telemetry_Log &log);
+
+#endif
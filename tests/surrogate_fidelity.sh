@@ -0,0 +1,26 @@
+#!/bin/sh
+# --surrogate with --fidelity: when the level changes, every pbest is simulated again at the new level
+# and Res_pbest must hold exactly those residuals (none of the predictions of the last screen).
+# Cheap levels (cme-ss, then cme) keep the run short and make the residuals deterministic.
+# usage: tests/surrogate_fidelity.sh [MAIN]   (run from the directory with exp_Calcium.dat)
+MAIN=${1:-./main}
+OUT=${TMPDIR:-/tmp}/surrogate_fidelity.$$
+$MAIN --seed 1 --engine cme --fidelity cme-ss --last-engine cme-ss --surrogate --verbosity 1 > $OUT || { echo "FAIL: $MAIN exited with $?"; rm -f $OUT; exit 1; }
+awk '
+    /Fidelity level/                    { raised = 1; n_eval = 0; n_pbest = 0; next }
+    !raised && /Surrogate .*particles simulated/ { if ($3 < $5) n_screened++ }
+    raised && /Residual being passed on/ { eval[n_eval++] = $NF }
+    raised && /pbest [0-9]+ re-evaluated/ {
+        if ($NF != eval[n_pbest]) { print "FAIL: pbest " $2 " is " $NF ", re-evaluated " eval[n_pbest]; bad = 1 }
+        n_pbest++
+        if (n_pbest == n_eval) raised = 0
+    }
+    END {
+        if (n_pbest == 0)     { print "FAIL: no fidelity level change"; exit 1 }
+        if (n_screened == 0)  { print "FAIL: the surrogate screened no particle before the level change"; exit 1 }
+        if (bad)              exit 1
+        print "PASS: " n_pbest " pbest residuals re-evaluated at the level change (" n_screened " screened iterations before it)"
+    }' $OUT
+STATUS=$?
+rm -f $OUT
+exit $STATUS
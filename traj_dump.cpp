@@ -0,0 +1,94 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Reader of the trajectory files of the final pass (make traj_dump; see trajectory.h).
+//
+//   ./traj_dump FILE          the header: model, time axis and the data points
+//   ./traj_dump FILE POINT    the time course of one point: time (s) and the occupancy of the 13 states
+//                             per frame, in the column layout of the other output files
+//
+// The file is memory-mapped, so only the columns of the printed point are read from disk.
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include "trajectory.h"
+
+using namespace std;
+
+static const char *state_Names[n_States] = { "S0", "S1", "S2", "S3", "S4", "S5", "S6a", "S7", "S6", "S8", "S9", "S10", "S11" };
+
+static void print_Header(const trajectory_Header &h)
+{
+    cout << "# points " << h.n_points << ", " << h.n_molecules << " molecules each, topology " << topology_Name((model_Topology)h.topology) << endl;
+    cout << "# frames " << h.n_frames << ", every " << h.frame_stride << " steps of dt = " << h.dt << " s" << endl;
+    cout << "# Ca_sr " << h.Ca_sr_conc << " Pi " << h.Pi_conc << " MgATP " << h.MgATP_conc << " MgADP " << h.MgADP_conc << endl;
+    for (int k = 0; k < n_Rates; k++)
+    {
+        cout << "# " << rate_Name(k) << " " << h.rates[k] << endl;
+    }
+    cout << "# point kind conc Ca_cyt" << endl;
+    for (uint32_t p = 0; p < h.n_points; p++)
+    {
+        cout << p << "  " << data_Kind_Name((data_Kind)h.kind[p]) << "  " << h.conc[p] << "  " << h.Ca_cyt[p] << endl;
+    }
+}
+
+static void print_Point(const trajectory_File &traj, int point)
+{
+    const trajectory_Header &h = *traj.header;
+    const uint32_t *column[n_States];
+    for (int s = 0; s < n_States; s++) column[s] = trajectory_Column(traj, point, s);
+
+    cout << "# t";
+    for (int s = 0; s < n_States; s++) cout << " " << state_Names[s];
+    cout << "\n";
+    const double scale = (h.n_molecules > 0) ? 1.0 / h.n_molecules : 0.0;
+    for (uint32_t f = 0; f < h.n_frames; f++)
+    {
+        cout << (double)f * h.frame_stride * h.dt;
+        for (int s = 0; s < n_States; s++) cout << "  " << column[s][f] * scale;
+        cout << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "usage: ./traj_dump FILE [POINT]" << endl;
+        return 1;
+    }
+    trajectory_File traj;
+    string error;
+    if (!trajectory_Map(traj, argv[1], error))
+    {
+        cerr << error << endl;
+        return 1;
+    }
+    int status = 0;
+    if (argc < 3)
+    {
+        print_Header(*traj.header);
+    }
+    else
+    {
+        int point = atoi(argv[2]);
+        if (point < 0 || point >= (int)traj.header->n_points)
+        {
+            cerr << "point " << argv[2] << " is not in " << argv[1] << " (" << traj.header->n_points << " points)" << endl;
+            status = 1;
+        }
+        else
+        {
+            print_Point(traj, point);
+        }
+    }
+    trajectory_Unmap(traj);
+    return status;
+}
@@ -0,0 +1,166 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Columnar binary trajectory files (see trajectory.h).
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trajectory.h"
+
+using namespace std;
+
+static const char     trajectory_Magic[8] = { 'S', 'E', 'R', 'C', 'A', 'T', 'R', 'J' };
+static const uint32_t trajectory_Version  = 2;
+static const uint64_t trajectory_Page     = 4096; // the columns start on a page of their own
+
+static_assert(sizeof(trajectory_Header) <= trajectory_Page, "trajectory_Header does not fit its page");
+
+// write all of size bytes at offset (pwrite may write less than asked)
+static bool write_At(int fd, const void *data, size_t size, uint64_t offset)
+{
+    const char *byte = (const char *)data;
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, byte, size, (off_t)offset);
+        if (n <= 0) return false;
+        byte   += n;
+        size   -= n;
+        offset += n;
+    }
+    return true;
+}
+
+bool trajectory_Open(trajectory_Writer &writer, const char *file, const serca_Model &model, const exp_Data &data,
+                     int n_molecules, int n_steps, int frame_stride)
+{
+    writer.fd           = -1;
+    writer.n_points     = data.n_points;
+    writer.frame_stride = (frame_stride > 0) ? frame_stride : 1;
+    writer.n_frames     = trajectory_Frames(n_steps, writer.frame_stride);
+    writer.data_offset  = trajectory_Page;
+
+    trajectory_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, trajectory_Magic, sizeof(header.magic));
+    header.version      = trajectory_Version;
+    header.n_states     = n_States;
+    header.n_points     = writer.n_points;
+    header.n_frames     = writer.n_frames;
+    header.frame_stride = writer.frame_stride;
+    header.n_molecules  = n_molecules;
+    header.topology     = model.topology;
+    header.data_offset  = writer.data_offset;
+    header.dt           = model.dt;
+    header.Ca_sr_conc   = model.Ca_sr_conc;
+    header.Pi_conc      = model.Pi_conc;
+    header.MgATP_conc   = model.MgATP_conc;
+    header.MgADP_conc   = model.MgADP_conc;
+    for (int k = 0; k < n_Rates; k++) header.rates[k] = model.rates[k];
+    for (int d = 0; d < data.n_datasets; d++)
+    {
+        const exp_Dataset &set = data.set[d];
+        for (int i = set.first; i < set.first + set.n_points; i++)
+        {
+            header.conc[i]   = data.conc[i];
+            header.Ca_cyt[i] = (set.kind == DATA_PHOSPHATE) ? set.Ca_cyt_conc : data.conc[i];
+            header.kind[i]   = set.kind;
+        }
+    }
+
+    int fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    uint64_t size = writer.data_offset + (uint64_t)writer.n_points * n_States * writer.n_frames * sizeof(uint32_t);
+    if (!write_At(fd, &header, sizeof(header), 0) || ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    writer.fd = fd;
+    return true;
+}
+
+bool trajectory_Write(trajectory_Writer &writer, int point, int first_frame, int n_frames, const uint32_t *counts)
+{
+    if (writer.fd < 0 || n_frames <= 0) return true;
+    bool ok = true;
+    for (int s = 0; s < n_States && ok; s++)
+    {
+        uint64_t offset = writer.data_offset + (((uint64_t)point * n_States + s) * writer.n_frames + first_frame) * sizeof(uint32_t);
+        ok = write_At(writer.fd, counts + s * trajectory_Chunk, n_frames * sizeof(uint32_t), offset);
+    }
+    return ok;
+}
+
+bool trajectory_Close(trajectory_Writer &writer)
+{
+    if (writer.fd < 0) return true;
+    bool ok = close(writer.fd) == 0;
+    writer.fd = -1;
+    return ok;
+}
+
+bool trajectory_Map(trajectory_File &traj, const char *file, string &error)
+{
+    traj.header = NULL;
+    traj.map    = NULL;
+    traj.size   = 0;
+    int fd = open(file, O_RDONLY);
+    if (fd < 0)
+    {
+        error = string("cannot open ") + file;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(trajectory_Header))
+    {
+        close(fd);
+        error = string(file) + " is not a trajectory file";
+        return false;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (map == MAP_FAILED)
+    {
+        error = string("cannot map ") + file;
+        return false;
+    }
+    const trajectory_Header *h = (const trajectory_Header *)map;
+    if (memcmp(h->magic, trajectory_Magic, sizeof(h->magic)) != 0 ||
+        h->n_points > (uint32_t)max_Data_Points || h->frame_stride == 0) // the header arrays hold max_Data_Points
+    {
+        error = string(file) + " is not a trajectory file";
+    }
+    else if (h->version != trajectory_Version || h->n_states != (uint32_t)n_States)
+    {
+        error = string(file) + " was written by another version of the program";
+    }
+    else if ((uint64_t)st.st_size < h->data_offset + (uint64_t)h->n_points * h->n_states * h->n_frames * sizeof(uint32_t))
+    {
+        error = string(file) + " is truncated";
+    }
+    else
+    {
+        traj.header = h;
+        traj.map    = map;
+        traj.size   = st.st_size;
+        return true;
+    }
+    munmap(map, st.st_size);
+    return false;
+}
+
+void trajectory_Unmap(trajectory_File &traj)
+{
+    if (traj.map != NULL) munmap((void *)traj.map, traj.size);
+    traj.header = NULL;
+    traj.map    = NULL;
+    traj.size   = 0;
+}
@@ -0,0 +1,95 @@
+/*-----------------------------------------------------------------------------------------------------
+// Time-course occupancies of the final pass (--trajectory FILE, --trajectory-stride N).
+//
+// lastRun marches every data point from S0 to the end of the steady-state window; with a trajectory
+// file it also counts the 13 states of all molecules every N time steps (a frame) and writes the counts
+// while the points are simulated, so only one chunk of frames per point is held in memory.
+//
+// The file is columnar and meant to be memory-mapped (native byte order):
+//
+//   trajectory_Header                      padded to data_offset (one page)
+//   uint32_t count[n_points][n_States][n_frames]
+//
+// count[p][s][f] is the number of molecules of point p in state s after f * frame_stride time steps
+// (frame 0: all in S0), so a state's time course is one contiguous column; the occupancy is
+// count / n_molecules. The whole file is sized when it is opened and every chunk goes to its place with
+// one large write per state (pwrite: the point threads do not share a file position). The header holds
+// what is needed to interpret the columns: rates, fixed concentrations, dt, stride and the points.
+//
+// trajectory_Map opens such a file read-only with mmap; trajectory_Column then points into the mapping
+// without copying (make traj_dump: a small command-line reader).
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "serca_Model.h"
+#include "update_States.h"
+#include "exp_Data.h"
+
+const int trajectory_Chunk = 4096; // frames per chunk (16 kB per state column)
+
+struct trajectory_Header
+{
+    char     magic[8];       // "SERCATRJ"
+    uint32_t version;
+    uint32_t n_states;
+    uint32_t n_points;
+    uint32_t n_frames;       // per point
+    uint32_t frame_stride;   // time steps between frames
+    uint32_t n_molecules;    // per point
+    uint32_t topology;       // model_Topology
+    uint32_t reserved;
+    uint64_t data_offset;    // bytes before the first column
+    float    dt;             // s
+    float    Ca_sr_conc, Pi_conc, MgATP_conc, MgADP_conc; // the fixed concentrations (M)
+    float    rates[n_Rates]; // by rate_Index
+    float    conc[max_Data_Points];   // the varied concentration of every point (M)
+    float    Ca_cyt[max_Data_Points]; // Ca_cyt_conc of every point (M): conc for Ca data
+    int32_t  kind[max_Data_Points];   // data_Kind of every point
+};
+
+struct trajectory_Writer
+{
+    int      fd; // -1: no trajectory
+    int      n_points, n_frames, frame_stride;
+    uint64_t data_offset;
+};
+
+// frames of a march of n_steps time steps (frames 0 ... n_steps / frame_stride)
+inline int trajectory_Frames(int n_steps, int frame_stride)
+{
+    return n_steps / frame_stride + 1;
+}
+
+bool trajectory_Open(trajectory_Writer &writer, const char *file, const serca_Model &model, const exp_Data &data,
+                     int n_molecules, int n_steps, int frame_stride);
+
+// frames first_frame ... first_frame + n_frames - 1 of point: counts[s * trajectory_Chunk + k] is
+// state s at frame first_frame + k; thread safe
+bool trajectory_Write(trajectory_Writer &writer, int point, int first_frame, int n_frames, const uint32_t *counts);
+
+bool trajectory_Close(trajectory_Writer &writer);
+
+struct trajectory_File
+{
+    const trajectory_Header *header; // NULL: not mapped
+    const void              *map;
+    size_t                   size;
+};
+
+bool trajectory_Map(trajectory_File &traj, const char *file, std::string &error);
+
+// the n_frames counts of state at point
+inline const uint32_t *trajectory_Column(const trajectory_File &traj, int point, int state)
+{
+    const trajectory_Header &h = *traj.header;
+    return (const uint32_t *)((const char *)traj.map + h.data_offset) + ((size_t)point * h.n_states + state) * h.n_frames;
+}
+
+void trajectory_Unmap(trajectory_File &traj);
+
+#endif
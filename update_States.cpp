@@ -12,7 +12,8 @@
 //
 //
 //
-// This portion of the code is used to update the states of each RUs based on the Markov step
+// This portion of the code builds the transition table used to update the states of each RUs based on the Markov step
+// (the step itself is update_States in update_States.h)
 //
 //-----------------------------------------------------------------------------------------------------------------------
 // EXAMPLE COMMENT :
@@ -108,77 +109,60 @@
 #include <string>
 #include <sstream>
 #include <time.h>
+#include "update_States.h"
 
 
-void update_States(int &state,        float &dt,
-                   float &k_S0_S1,    float &k_S0_S11,
-                   float &Ca_cyt_conc,float &Ca_sr_conc,
-                   float &Pi_conc,    float &MgATP_conc, float &MgADP_conc,
-                   float &k_S1_S2,    float &k_S1_S0,
-                   float &k_S2_S3,    float &k_S2_S1,
-                   float &k_S3_S4,    float &k_S3_S2,
-                   float &k_S4_S5,    float &k_S4_S3,
-                   float &k_S5_S6a,    float &k_S5_S4,
-                   float &k_S5_S6,    float &k_S6_S5,
-                   float &k_S6a_S7,    float &k_S6a_S5,
-                   float &k_S7_S8,    float &k_S7_S6a,
-                   float &k_S7_S6,    float &k_S6_S7,
-                   float &k_S8_S9,   float &k_S8_S7,
-                   float &k_S9_S10,  float &k_S9_S8,
-                   float &k_S10_S11,  float &k_S10_S9,
-                   float &k_S11_S0,   float &k_S11_S10
-                   )
+//------------------------------------------------------------------
+// The topology of the scheme as data: for every state (index, see update_States.h) its outgoing edges in
+// bucket order, each with its rate, the concentration that makes it pseudo-first order (if any) and the
+// destination. The threshold of edge e is  k * conc * dt,  added to the previous threshold for the
+// "cumulative" states. The rows reproduce the original if/else chain exactly, quirks included (state 5,
+// and the non-cumulative states 10 - 12), so a random number leads to the same transition as before.
+//------------------------------------------------------------------
+enum conc_Factor { CONC_NONE = 0, CONC_CA_CYT, CONC_CA_SR, CONC_PI, CONC_MGATP, CONC_MGADP, n_Conc };
 
+struct topology_Edge
 {
-    int current_state;
-    float p1, p2, p3; //Probabilities of each state
-    float randNum = 0;
-    //
-    //-------------------------------------------------------------------------------------------------------------------------
-    current_state = state;     // get current state ID number (e.g. 0 = E , etc)
-    //
-    //setting index equal from 0 to 12 for each state
-    //
-    //
-    // generate random numbers
-    randNum = static_cast <float> (rand()) / static_cast <float> (RAND_MAX); // Generate a random number between 0 and 1
-/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    int rate; // rate_Index
+    int conc; // conc_Factor
+    int to;   // destination state
+};
+
+struct topology_Row
+{
+    int           n_edges;
+    bool          cumulative;   // p2 = p1 + k2 * conc * dt (otherwise p2 = max(p1, k2 * conc * dt))
+    topology_Edge edge[max_Branch];
+};
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 //_________________________________________________________________________________________________
 //
 //
 //-------------------------------------------------------------------------------------------------
 //
-//                      SERCA MONTE CARLO MARKOV CHAIN LOOP INTEGRATION STARTS HERE:
+//                      SERCA MONTE CARLO MARKOV CHAIN SCHEME (Inesi 1988)
 //
 //-------------------------------------------------------------------------------------------------
-//
-// if(state  = 0): Then   S11 [*E-Pi]  <-- S0 {E} --> S1 [E.Ca]                 else stay as E
-//          [S1]
-//          E.Ca
-//           /\
-//           ||
-//           \/
-//    (Pi +) E <==> *E-Pi
-//          [S0]    [S11]
-//
-//__________________________________________________________________________________________________
-//
-//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-//__________________________________________________________________________________________________   
 */
-    if(current_state == 0)
-    {
-        p1 =       (k_S0_S1  * Ca_cyt_conc * dt); // (pseudo first-order) bimolecular  forward transition to  E.Ca          [S1]
-        p2 = p1 +  (k_S0_S11 * Pi_conc     * dt); // (pseudo first-order) bimolecular backward transition to *E-Pi          [S11]
-        if(randNum < p1)  //If the random number is less than first probability, then transition to the next state
-        {
-            state = 1;   // forward transition to  E.Ca [S1]
-        }
-        else if(randNum < p2) //If the random number is less than second probability , then transition to the previous state
-        {
-            state = 12; // backward transition to *E-Pi [S11]
-        }
-    } //if it is not greater than either probability then stay in the same state
+static constexpr topology_Row inesi_Rows[n_States] = {
+    /*-------------------------------------------------------------------------------------------------
+    // if(state  = 0): Then   S11 [*E-Pi]  <-- S0 {E} --> S1 [E.Ca]                 else stay as E
+    //          [S1]
+    //          E.Ca
+    //           /\
+    //           ||
+    //           \/
+    //    (Pi +) E <==> *E-Pi
+    //          [S0]    [S11]
+    //
+    //__________________________________________________________________________________________________
+    //
+    //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+    //__________________________________________________________________________________________________
+    */
+    // S0  --> S1 (E.Ca), S11 (*E-Pi)
+    { 2, true , { { K_S0_S1,   CONC_CA_CYT, 1  }, { K_S0_S11,  CONC_PI,    12 } } },
     /*
     //-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -193,22 +177,9 @@ void update_States(int &state,        float &dt,
     //    (Pi +) E
     //          [S0]
     //-----------------------------------------------------------------------------------------------------------------------
-*/
-    if(current_state == 1)
-    {
-        p1 =       (k_S1_S2  * dt);  //(first order)  unimolecular  forward transition forward E'.Ca          [S2]
-        p2 = p1 +  (k_S1_S0  * dt); // (first order)  unimolecular backward transition back to E              [S0]
-        if(randNum < p1)  //f your random number is less than first probability , then transition to next state
-        {
-            state = 2;   // forward transition to  E'.Ca    [S2]
-        }
-        else if(randNum < p2) //If the random number is less than second probability , then transition to the previous state
-        {
-            state = 0;
-        }
-    }
-    
-    
+    */
+    // S1  --> S2 (E'.Ca), S0 (E)
+    { 2, true , { { K_S1_S2,   CONC_NONE,   2  }, { K_S1_S0,   CONC_NONE,  0  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -219,20 +190,9 @@ void update_States(int &state,        float &dt,
     //          E.Ca <==> E'.Ca  + Ca <==> E'.Ca2
     //
     //-----------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 2)
-    {
-        p1 =       (k_S2_S3 * Ca_cyt_conc * dt); // (pseudo-first order)  bimolecular  forward transition to E'.Ca2             [S3]
-        p2 = p1 +  (k_S2_S1 			  * dt); // (first-order)        unimolecular backward transition to E.Ca               [S0]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state              [S3]
-        {
-            state = 3;   // forward transition to E'.Ca2    [S3]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state [S0]
-        {
-            state = 1; // backward transition to  E'.Ca     [S1]
-        }
-    } //if it is not greater than either probability  then stay in the same state
+    */
+    // S2  --> S3 (E'.Ca2), S1 (E.Ca)
+    { 2, true , { { K_S2_S3,   CONC_CA_CYT, 3  }, { K_S2_S1,   CONC_NONE,  1  } } },
     /*
     //
     //-----------------------------------------------------------------------------------------------------------------------
@@ -247,22 +207,9 @@ void update_States(int &state,        float &dt,
     //
     //
     //-----------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 3)
-    {
-        p1 =       (k_S3_S4 * MgATP_conc * dt);     // (pseudo first-order) bimolecular   forward transition to E'.ATP.Ca2 [S4]
-        p2 = p1 +  (k_S3_S2              * dt);     // (first order)        unimolecular backward transition to E'.Ca      [S2]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 4;   // forward transition to E'.ATP.Ca2 [S4]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 2;  // backward transition to E'.Ca      [S2]
-        }
-    } //if it is not greater than either probability then stay in the same state
-    
-    
+    */
+    // S3  --> S4 (E'.ATP.Ca2), S2 (E'.Ca)
+    { 2, true , { { K_S3_S4,   CONC_MGATP,  4  }, { K_S3_S2,   CONC_NONE,  2  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -274,21 +221,9 @@ void update_States(int &state,        float &dt,
     //  E'.Ca2 (+ ATP) <==> E'.ATP.Ca2  <==>   E'~P.ADP.Ca2
     //
     //-----------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 4)
-    {
-        p1 =       (k_S4_S5 * dt);     // (first order) unimolecular  forward transition to E'~P.ADP.Ca2 [S5]
-        p2 = p1 +  (k_S4_S3 * dt);     // (first order) unimolecular backward transition to E'.Ca2       [S3]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 5;   // forward transition to E'~P.ADP.Ca2 [S5]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 3;  // backward transition to E'.Ca2       [S3]
-        }
-    } //if it is not greater than either probability  then stay in the same state
-    
+    */
+    // S4  --> S5 (E'~P.ADP.Ca2), S3 (E'.Ca2)
+    { 2, true , { { K_S4_S5,   CONC_NONE,   5  }, { K_S4_S3,   CONC_NONE,  3  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -306,25 +241,10 @@ void update_States(int &state,        float &dt,
     //
     //
     //--------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 5)
-    {
-        p1 =        (k_S5_S6a * dt); // (first order)  unimolecular  forward transition to *E'-P.ADP.Ca2               [S6a]
-        p2 = p1 +   (k_S5_S4 * dt); // (first order)  unimolecular backward transition to  E'.ATP.Ca2                 [S4]
-        p3 = p2 +   (k_S5_S6 * dt); // (first order)  unimolecular  forward transition to  E'~P.Ca2                   [S6]
-        if(randNum < p1)
-        {
-            state = 6;   //forward transition to *E'-P.ADP.Ca2 [S6a]
-        }
-        else if(randNum < p2)
-        {
-            state = 8;  //forward transition to  E'~P.Ca2      [S6]
-        }
-        else if(randNum < p3)
-        {
-            state = 4; //reverse transition to   E'.ATP.Ca2    [S4]
-        }
-    }
+    */
+    // S5  --> S6a, S6, S4. NB: as in the original chain, the k_S5_S4 bucket goes to E'~P.Ca2 [S6] (index 8)
+    //                       and the k_S5_S6 bucket to E'.ATP.Ca2 [S4]
+    { 3, true , { { K_S5_S6a,  CONC_NONE,   6  }, { K_S5_S4,   CONC_NONE,  8  }, { K_S5_S6,  CONC_NONE, 4 } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -344,22 +264,9 @@ void update_States(int &state,        float &dt,
     //                   [S7]
     //
     //----------------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 6)
-    {
-        p1 =       (k_S6a_S7 * dt);     // (first order) uniimolecular   forward transition to *E'-P.Ca2                 [S7]
-        p2 = p1 +  (k_S6a_S5 * dt);     // (first order) unimolecular   backward transition to  E'~P.ADP.Ca2             [S5]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 7;   // forward transition to *E'-P.Ca2    [S7]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 5;  // backward transition to E'~P.ADP.Ca2 [S5]
-        }
-    } //if it is not greater than either probability  then stay in the same state
-    
-    
+    */
+    // S6a --> S7 (*E'-P.Ca2), S5 (E'~P.ADP.Ca2)
+    { 2, true , { { K_S6a_S7,  CONC_NONE,   7  }, { K_S6a_S5,  CONC_NONE,  5  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -376,25 +283,9 @@ void update_States(int &state,        float &dt,
     //
     //
     //-------------------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 7)
-    {
-        p1 =      (k_S7_S8              * dt); // (first order)         unimolecular  forward transition to *E'-P.Ca            [S8]
-        p2 = p1 + (k_S7_S6a * MgADP_conc * dt); // (pseudo-first order)   bimolecular backward transition to *E'-P.ADP.Ca2       [S6a]
-        p3 = p2 + (k_S7_S6              * dt); // (first order)         unimolecular backward transition to  E'~P.Ca2           [S6]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 9; //forward transition to *E'-P.Ca         [S8]
-        }
-        else if(randNum < p2)
-        {
-            state = 6; //reverse transition to *E'-P.ADP.Ca2    [S6a]
-        }
-        else if(randNum < p3)
-        {
-            state = 8; //reverse transition to  E'~P.Ca2        [S6]
-        }
-    }
+    */
+    // S7  --> S8 (*E'-P.Ca), S6a (*E'-P.ADP.Ca2), S6 (E'~P.Ca2)
+    { 3, true , { { K_S7_S8,   CONC_NONE,   9  }, { K_S7_S6a,  CONC_MGADP, 6  }, { K_S7_S6,  CONC_NONE, 8 } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -415,21 +306,9 @@ void update_States(int &state,        float &dt,
     //
     //
     //------------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 8)
-    {
-        p1 =       (k_S6_S7			     * dt);     // (first order)        unimolecular  forward transition to *E'-P.Ca2                      [S7]
-        p2 = p1 +  (k_S6_S5 * MgADP_conc * dt);     // (pseudo-first order)  bimolecular backward transition to E'~P.ADP.Ca2                   [S5]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 7;   // forward transition to *E'-P.Ca2      [S7]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 5;  // backward transition to  E'~P.ADP.Ca2  [S5]
-        }
-    } //if it is not greater than either probability  then stay in the same state
-    
+    */
+    // S6  --> S7 (*E'-P.Ca2), S5 (E'~P.ADP.Ca2)
+    { 2, true , { { K_S6_S7,   CONC_NONE,   7  }, { K_S6_S5,   CONC_MGADP, 5  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -440,21 +319,9 @@ void update_States(int &state,        float &dt,
     //  [S7]              [S8]          [S9]
     //
     //------------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state == 9)
-    {
-        p1 =       (k_S8_S9 			   * dt);     // (first-order)         unimolecular  forward transition to *E-P.Ca    [S9]
-        p2 = p1 +  (k_S8_S7  * Ca_sr_conc  * dt);     // (pseudo-first order)   bimolecular backward transition to *E'-P.Ca2  [S7]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 10;   // forward transition to *E-P.Ca      [S9]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 7;   // backward transition to *E'-P.Ca2    [S7]
-        }
-    } //if it is not greater than either probability  then stay in the same state
-    
+    */
+    // S8  --> S9 (*E-P.Ca), S7 (*E'-P.Ca2)
+    { 2, true , { { K_S8_S9,   CONC_NONE,   10 }, { K_S8_S7,   CONC_CA_SR, 7  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -465,22 +332,9 @@ void update_States(int &state,        float &dt,
     //     [S8]         [S9]         [S10]
     //
     //-------------------------------------------------------------------------------------------------------------------------
-*/
-    
-    else if(current_state == 10)
-    {
-        p1 =       (k_S9_S10 * dt);      //(first-order) unimolecular  forward transition to *E-P        [S10]
-        p2 =       (k_S9_S8  * dt);     // (first-order)  bimolecular backward transition to *E'-P.Ca    [S8]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 11;   // forward transition to *E-P         [S10]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 9; // backward transition to   *E'-P.Ca     [S8]
-        }
-    } //if it is not greater than either probability  then stay in the same state
-    
+    */
+    // S9  --> S10 (*E-P), S8 (*E'-P.Ca). NB: not cumulative (as in the original chain)
+    { 2, false, { { K_S9_S10,  CONC_NONE,   11 }, { K_S9_S8,   CONC_NONE,  9  } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -492,20 +346,8 @@ void update_States(int &state,        float &dt,
     //
     //-------------------------------------------------------------------------------------------------------------------------
     */
-    else if(current_state ==11)
-    {
-        p1 =       (k_S10_S11              * dt);    // (first-order)       unimolecular  forward transition to *E-Pi       [S11]
-        p2 =       (k_S10_S9 * Ca_sr_conc * dt);    // (pseudo first-order) bimolecular backward transition to *E-P.Ca     [S9]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 12;   // forward transition to *E-Pi        [S11]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
-        {
-            state = 10; // backward transition to  *E-P.Ca      [S9]
-        }
-    } //if it is not greater than either probability  then stay in the same state
-    
+    // S10 --> S11 (*E-Pi), S9 (*E-P.Ca). NB: not cumulative
+    { 2, false, { { K_S10_S11, CONC_NONE,   12 }, { K_S10_S9,  CONC_CA_SR, 10 } } },
     /*-----------------------------------------------------------------------------------------------------------------------
     //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
     //-----------------------------------------------------------------------------------------------------------------------
@@ -516,19 +358,69 @@ void update_States(int &state,        float &dt,
     //   [S10]      [S11]      [S0]
     //
     //------------------------------------------------------------------------------------------------------------------------
-*/
-    else if(current_state ==12)
+    */
+    // S11 --> S0 (E), S10 (*E-P). NB: not cumulative
+    { 2, false, { { K_S11_S0,  CONC_NONE,   0  }, { K_S11_S10, CONC_NONE,  11 } } }
+};
+
+//------------------------------------------------------------------
+// reduced topology: the S5 -> S6 -> S7 side path dropped (no k_S5_S6 / k_S7_S6 edge, and the k_S5_S4 bucket
+// goes to S4). S6 keeps its outgoing edges, so it is simply never entered.
+//------------------------------------------------------------------
+static constexpr topology_Row no_S6_Rows[n_States] = {
+    { 2, true , { { K_S0_S1,   CONC_CA_CYT, 1  }, { K_S0_S11,  CONC_PI,    12 } } }, // S0  --> S1, S11
+    { 2, true , { { K_S1_S2,   CONC_NONE,   2  }, { K_S1_S0,   CONC_NONE,  0  } } }, // S1  --> S2, S0
+    { 2, true , { { K_S2_S3,   CONC_CA_CYT, 3  }, { K_S2_S1,   CONC_NONE,  1  } } }, // S2  --> S3, S1
+    { 2, true , { { K_S3_S4,   CONC_MGATP,  4  }, { K_S3_S2,   CONC_NONE,  2  } } }, // S3  --> S4, S2
+    { 2, true , { { K_S4_S5,   CONC_NONE,   5  }, { K_S4_S3,   CONC_NONE,  3  } } }, // S4  --> S5, S3
+    { 2, true , { { K_S5_S6a,  CONC_NONE,   6  }, { K_S5_S4,   CONC_NONE,  4  } } }, // S5  --> S6a, S4
+    { 2, true , { { K_S6a_S7,  CONC_NONE,   7  }, { K_S6a_S5,  CONC_NONE,  5  } } }, // S6a --> S7, S5
+    { 2, true , { { K_S7_S8,   CONC_NONE,   9  }, { K_S7_S6a,  CONC_MGADP, 6  } } }, // S7  --> S8, S6a
+    { 2, true , { { K_S6_S7,   CONC_NONE,   7  }, { K_S6_S5,   CONC_MGADP, 5  } } }, // S6  --> S7, S5
+    { 2, true , { { K_S8_S9,   CONC_NONE,   10 }, { K_S8_S7,   CONC_CA_SR, 7  } } }, // S8  --> S9, S7
+    { 2, false, { { K_S9_S10,  CONC_NONE,   11 }, { K_S9_S8,   CONC_NONE,  9  } } }, // S9  --> S10, S8
+    { 2, false, { { K_S10_S11, CONC_NONE,   12 }, { K_S10_S9,  CONC_CA_SR, 10 } } }, // S10 --> S11, S9
+    { 2, false, { { K_S11_S0,  CONC_NONE,   0  }, { K_S11_S10, CONC_NONE,  11 } } }   // S11 --> S0, S10
+};
+
+//------------------------------------------------------------------
+// the table of one topology; rows is a compile-time constant, so every threshold reduces to
+// a product of the model values the row names
+//------------------------------------------------------------------
+template <const topology_Row (&rows)[n_States]>
+static void build_Rows(transition_Table &table, const serca_Model &model, float Ca_cyt_conc)
+{
+    const float conc[n_Conc] = { 1.0f, Ca_cyt_conc, model.Ca_sr_conc, model.Pi_conc, model.MgATP_conc, model.MgADP_conc };
+    const float dt = model.dt;
+    for (int s = 0; s < n_States; s++)
     {
-        p1 =       (k_S11_S0  * dt);    // (first order) unimolecular forward transition to  E                       [S0]
-        p2 =       (k_S11_S10 * dt);    // (first order) bimolecular backward transition to *E-P                     [S10]
-        if(randNum < p1) //If the random number is less than first probability , then transition to next state
-        {
-            state = 0;   // forward transition to  E            [S0]
-        }
-        else if(randNum < p2)//If the random number is less than second probability , then transition to previous state
+        const topology_Row &row = rows[s];
+        float p = 0.0f;
+        int   to = s;
+        for (int e = 0; e < max_Branch; e++)
         {
-            state = 11; // backward transition to *E-P          [S10]
+            if (e < row.n_edges)
+            {
+                const topology_Edge &edge = row.edge[e];
+                float step = model.rates[edge.rate] * conc[edge.conc] * dt;
+                if (e == 0)              p = step;
+                else if (row.cumulative) p = p + step;
+                else if (step > p)       p = step;
+                to = edge.to;
+            }
+            // a state with fewer edges repeats its last threshold and destination
+            table.p[s][e]    = p;
+            table.next[s][e] = to;
         }
-    } //if it is not greater than either probability  then stay in the same state
-    return;
+        table.next[s][max_Branch] = s; //if it is not greater than any probability then stay in the same state
+    }
+}
+
+void build_Transition_Table(transition_Table &table, const serca_Model &model, float Ca_cyt_conc)
+{
+    switch (model.topology)
+    {
+        case TOPOLOGY_NO_S6: build_Rows<no_S6_Rows>(table, model, Ca_cyt_conc); break;
+        default:             build_Rows<inesi_Rows>(table, model, Ca_cyt_conc); break;
+    }
 }
@@ -0,0 +1,72 @@
+/*-----------------------------------------------------------------------------------------------------
+// Table-driven Markov step of one SERCA molecule.
+//
+// build_Transition_Table folds the rates, the Ca / ATP / ADP / Pi pseudo-first-order factors and dt
+// into (at most) three cumulative thresholds per state. It is called once per serca_Model and
+// Ca_cyt_conc (see update_States.cpp for the state-by-state description of the scheme).
+// update_States then only compares the random number against the thresholds of the current state
+// and looks up the destination ("bucket" 3 = stay in the same state).
+//-----------------------------------------------------------------------------------------------------
+*/
+#ifndef UPDATE_STATES_H
+#define UPDATE_STATES_H
+
+#include "serca_Model.h"
+
+const int n_States   = 13; // S0 ... S11 plus S6a (state indices 0 ... 12)
+                           // index: 0 S0 | 1 S1 | 2 S2 | 3 S3 | 4 S4 | 5 S5 | 6 S6a | 7 S7 | 8 S6 | 9 S8 | 10 S9 | 11 S10 | 12 S11
+const int max_Branch = 3;  // at most three outgoing transitions per state
+
+struct transition_Table
+{
+    float p   [n_States][max_Branch];     // cumulative transition probabilities per time step
+    int   next[n_States][max_Branch + 1]; // destination of each bucket, next[s][3] = s
+};
+
+void build_Transition_Table(transition_Table &table, const serca_Model &model, float Ca_cyt_conc);
+
+//------------------------------------------------------------------
+// one time step of one molecule: one row load, three compares
+//------------------------------------------------------------------
+inline void update_States(int &state, float randNum, const transition_Table &table)
+{
+    const float *p = table.p[state];
+    int bucket = (randNum >= p[0]) + (randNum >= p[1]) + (randNum >= p[2]);
+    state = table.next[state][bucket];
+}
+
+//------------------------------------------------------------------
+// per-step probability of each bucket of state s for a uniform draw in [0,1), exactly as update_States
+// interprets the thresholds (also when a rate set far outside the PSO bounds makes them negative or
+// non-monotone). prob[max_Branch] is the probability of staying. Used to turn the table into rates.
+//------------------------------------------------------------------
+inline void branch_Probabilities(const transition_Table &table, int s, double prob[max_Branch + 1])
+{
+    const float *p = table.p[s];
+    double cut[max_Branch + 2];
+    cut[0] = 0.0;
+    for (int k = 0; k < max_Branch; k++)
+    {
+        double c = p[k];
+        cut[k + 1] = (c < 0.0) ? 0.0 : (c > 1.0) ? 1.0 : c;
+    }
+    cut[max_Branch + 1] = 1.0;
+    for (int i = 1; i < max_Branch + 2; i++) // insertion sort of the breakpoints
+    {
+        for (int j = i; j > 0 && cut[j] < cut[j - 1]; j--)
+        {
+            double tmp = cut[j]; cut[j] = cut[j - 1]; cut[j - 1] = tmp;
+        }
+    }
+    for (int k = 0; k <= max_Branch; k++) prob[k] = 0.0;
+    for (int i = 0; i < max_Branch + 1; i++)
+    {
+        double width = cut[i + 1] - cut[i];
+        if (width <= 0.0) continue;
+        double u = 0.5 * (cut[i] + cut[i + 1]); // every draw inside this interval lands in the same bucket
+        int bucket = (u >= p[0]) + (u >= p[1]) + (u >= p[2]);
+        prob[bucket] += width;
+    }
+}
+
+#endif
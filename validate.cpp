@@ -0,0 +1,246 @@
+/*-----------------------------------------------------------------------------------------------------
+//                     University of California, San Diego
+//                      Dept. of Chemistry & Biochemistry
+//-----------------------------------------------------------------------------------------------------
+// Authors: Sophia P. Hirakis & Kimberly J. McCabe
+// Year  :  4/2018
+//-----------------------------------------------------------------------------------------------------
+// Statistical regression test of the SERCA MCMC engines (make validate; ./validate).
+//
+// The reference is the scalar fixed-dt engine, i.e. the update_States path main has always used. Every
+// engine variant simulates the steady-state bound Ca of the pCa curve of exp_Calcium.dat with the
+// Inesi (1988) reference rates and the production time axis (max_tsteps, dt, steady-state window), and
+// each point is compared with the reference:
+//
+//      z = (bound - bound_ref) / sqrt(se^2 + se_ref^2)
+//
+// The standard errors come from the spread of --batches independent batches of molecules (the
+// molecules have their own random streams, so the batch means are independent whatever the time
+// correlation inside a trajectory); the deterministic CME engines have se = 0. All engines use the same
+// seed and stream, so the SIMD variants, which draw the very same numbers as the scalar engine, must
+// reproduce it exactly (z = 0); sharing the streams only makes the test stricter. A variant passes if
+// |z| <= --z at every point. Its wall time for the whole curve and the speedup over the reference are
+// reported with it, so speed and accuracy are tracked together.
+//
+// cme-ss is listed but not judged: it is the t -> infinity limit of the chain, and with the reference
+// rates the production window (the last 1 ms of 10 ms) is still far from it (bound Ca 0.015 against 0.84
+// at the lowest pCa), so its z only shows how far from relaxed the window is.
+//
+// usage: ./validate [--molecules N] [--batches B] [--z Z] [--seed S] [--ca-data FILE]
+// exit status: 0 if every variant passes, 1 otherwise
+//-----------------------------------------------------------------------------------------------------
+*/
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <math.h>
+#include <stdlib.h>
+#include "steady_State.h"
+#include "exp_Data.h"
+#include "gpu_Engine.h"
+
+using namespace std;
+
+const int max_tsteps = 100001;
+
+struct validate_Variant
+{
+    const char *name;
+    const char *label;   // column of the per-pCa table
+    sim_Engine  engine;
+    simd_Level  simd;
+    bool        fused;
+    bool        windowed; // estimates the window average of the reference (else: listed, not judged)
+};
+
+// variants[0] is the reference
+const validate_Variant variants[] = {
+    { "fixed-dt scalar",  "scalar",   ENGINE_FIXED_DT,   SIMD_SCALAR, false, true  },
+    { "fixed-dt avx2",    "avx2",     ENGINE_FIXED_DT,   SIMD_AVX2,   false, true  },
+    { "fixed-dt avx512",  "avx512",   ENGINE_FIXED_DT,   SIMD_AVX512, false, true  },
+    { "fixed-dt fused",   "fused",    ENGINE_FIXED_DT,   SIMD_AUTO,   true,  true  },
+    { "gillespie",        "gillesp",  ENGINE_GILLESPIE,  SIMD_AUTO,   false, true  },
+    { "population",       "popul",    ENGINE_POPULATION, SIMD_AUTO,   false, true  },
+    { "cme",              "cme",      ENGINE_CME,        SIMD_AUTO,   false, true  },
+    { "cme-ss",           "cme-ss",   ENGINE_CME_SS,     SIMD_AUTO,   false, false },
+    { "gpu",              "gpu",      ENGINE_GPU,        SIMD_AUTO,   false, true  },
+};
+const int n_Variants = sizeof(variants) / sizeof(variants[0]);
+
+// bound Ca of one pCa point, over the molecules of all batches
+struct point_Estimate
+{
+    double bound;
+    double se; // standard error of bound, 0 for the deterministic engines
+};
+
+static double seconds_Since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// an explicitly requested SIMD level the CPU lacks is not validated (it would silently run narrower),
+// nor the GPU engine without a device (it would re-time the fixed-dt engine on the CPU)
+static bool variant_Supported(const validate_Variant &v)
+{
+    if (v.engine == ENGINE_GPU && !gpu_Available()) return false;
+    return v.simd == SIMD_AUTO || resolve_Simd_Level(v.simd) == v.simd;
+}
+
+// Ca bound per SERCA: S1 + S2 + S9 + S8 + 2 * (S3 + S4 + S5 + S6a + S7 + S6), as get_Residual
+static double bound_Ca(const ss_Accumulator &acc)
+{
+    float SS[n_States];
+    ss_Occupancy(acc, SS);
+    return SS[1] + SS[2] + SS[10] + SS[9] + 2* (SS[3] + SS[4] + SS[5] + SS[6] + SS[7] + SS[8]);
+}
+
+//------------------------------------------------------------------
+// the whole curve with variant v: estimate[c] for every point, the seconds it took
+//------------------------------------------------------------------
+static double run_Curve(const validate_Variant &v, const serca_Model &model, const transition_Table tables[],
+                        int n_points, int n_molecules, int n_batches, unsigned long long seed,
+                        point_Estimate estimate[])
+{
+    sim_Config config;
+    config.n_molecules = n_molecules;
+    config.max_tsteps  = max_tsteps;
+    config.window      = make_Window(max_tsteps, 10000, 1000);
+    config.engine      = v.engine;
+    config.simd        = v.simd;
+    config.fused_pCa   = v.fused;
+    config.verbose     = false;
+    if (!engine_Is_Stochastic(v.engine)) n_batches = 1; // every batch would give the same curve
+
+    double sum[max_Data_Points], sum2[max_Data_Points];
+    for (int c = 0; c < n_points; c++) sum[c] = sum2[c] = 0.0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int b = 0; b < n_batches; b++)
+    {
+        int first   = (int)((long long)n_molecules * b / n_batches);
+        int n_batch = (int)((long long)n_molecules * (b + 1) / n_batches) - first;
+        ss_Accumulator acc[max_Data_Points];
+        for (int c = 0; c < n_points; c++) ss_Clear(acc[c]);
+        engine_Accumulate_Sweep(config, tables, n_points, model.dt, seed, 0, first, n_batch, acc);
+        for (int c = 0; c < n_points; c++)
+        {
+            double bound = bound_Ca(acc[c]);
+            sum[c]  += bound;
+            sum2[c] += bound * bound;
+        }
+    }
+    double seconds = seconds_Since(start);
+    for (int c = 0; c < n_points; c++)
+    {
+        estimate[c].bound = sum[c] / n_batches;
+        estimate[c].se    = 0.0;
+        if (n_batches > 1)
+        {
+            double var = (sum2[c] - sum[c] * sum[c] / n_batches) / (n_batches - 1);
+            estimate[c].se = sqrt(var > 0.0 ? var / n_batches : 0.0);
+        }
+    }
+    return seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    int    n_molecules = 2000;
+    int    n_batches   = 10;
+    double z_max       = 4.0;
+    unsigned long long seed = 20180401ULL;
+    string ca_data_file = "exp_Calcium.dat";
+    for (int a = 1; a < argc; a++)
+    {
+        if      (string(argv[a]) == "--molecules" && a+1 < argc) n_molecules  = atoi(argv[++a]);
+        else if (string(argv[a]) == "--batches"   && a+1 < argc) n_batches    = atoi(argv[++a]);
+        else if (string(argv[a]) == "--z"         && a+1 < argc) z_max        = atof(argv[++a]);
+        else if (string(argv[a]) == "--seed"      && a+1 < argc) seed         = strtoull(argv[++a], NULL, 10);
+        else if (string(argv[a]) == "--ca-data"   && a+1 < argc) ca_data_file = argv[++a];
+    }
+    if (n_batches < 2) n_batches = 2;
+    if (n_molecules < n_batches) n_molecules = n_batches;
+    const serca_Model model = inesi_Model();
+    static exp_Data data; // the experimental pCa curve, as main fits it
+    string error;
+    exp_Clear(data);
+    if (!load_Dataset(data, ca_data_file.c_str(), DATA_CALCIUM, 1.0f, 0.0f, error))
+    {
+        cout << " " << error << endl;
+        return 1;
+    }
+    const int n_points = data.n_points;
+    static transition_Table tables[max_Data_Points];
+    build_Data_Tables(tables, model, data);
+
+    cout << " SERCA MCMC engine validation : seed " << seed << ", " << n_points << " pCa points, " << n_molecules
+         << " molecules in " << n_batches << " batches, pass if |z| <= " << z_max << endl;
+    if (!gpu_Available()) cout << " gpu: " << gpu_Device_Name() << ", not validated" << endl;
+
+    static point_Estimate estimate[n_Variants][max_Data_Points];
+    double seconds[n_Variants];
+    bool   supported[n_Variants];
+    for (int i = 0; i < n_Variants; i++)
+    {
+        supported[i] = variant_Supported(variants[i]);
+        seconds[i]   = supported[i] ? run_Curve(variants[i], model, tables, n_points, n_molecules, n_batches, seed, estimate[i]) : 0.0;
+    }
+
+    //-------------------------------
+    // per-pCa agreement with the reference
+    //-------------------------------
+    cout << endl << " z of every point against " << variants[0].name << endl;
+    cout << "   " << setw(6) << "pCa" << setw(18) << "bound Ca (ref)";
+    for (int i = 1; i < n_Variants; i++) cout << setw(9) << variants[i].label;
+    cout << endl;
+    double z_worst[n_Variants];
+    int    n_failed[n_Variants];
+    for (int i = 0; i < n_Variants; i++) z_worst[i] = 0.0, n_failed[i] = 0;
+    for (int c = 0; c < n_points; c++)
+    {
+        const point_Estimate &ref = estimate[0][c];
+        cout << "   " << fixed << setprecision(3) << setw(6) << -log10(data.conc[c])
+             << setprecision(5) << setw(10) << ref.bound << " +- " << setprecision(2) << scientific << ref.se << fixed;
+        for (int i = 1; i < n_Variants; i++)
+        {
+            if (!supported[i]) { cout << setw(9) << "n/a"; continue; }
+            double se = sqrt(ref.se * ref.se + estimate[i][c].se * estimate[i][c].se);
+            double d  = estimate[i][c].bound - ref.bound;
+            double z  = (se > 0.0) ? d / se : (d == 0.0 ? 0.0 : HUGE_VAL);
+            if (fabs(z) > z_worst[i]) z_worst[i] = fabs(z);
+            if (fabs(z) > z_max && variants[i].windowed) n_failed[i]++;
+            cout << setprecision(2) << setw(8) << z << (fabs(z) > z_max && variants[i].windowed ? "*" : " ");
+        }
+        cout << endl;
+    }
+
+    //-------------------------------
+    // summary: accuracy and speed
+    //-------------------------------
+    cout << endl << "   " << left << setw(18) << "variant" << right << setw(12) << "s / curve" << setw(12) << "speedup"
+         << setw(10) << "max |z|" << setw(12) << "in CI" << setw(8) << "" << endl;
+    bool all_pass = true;
+    for (int i = 0; i < n_Variants; i++)
+    {
+        cout << "   " << left << setw(18) << variants[i].name << right;
+        if (!supported[i]) { cout << setw(12) << "n/a" << endl; continue; }
+        bool pass = n_failed[i] == 0;
+        all_pass = all_pass && pass;
+        cout << fixed << setprecision(6) << setw(12) << seconds[i] << setprecision(1) << setw(11) << seconds[0] / seconds[i] << "x";
+        if (i == 0)
+        {
+            cout << setw(10) << "-" << setw(12) << "reference" << endl;
+            continue;
+        }
+        cout << setprecision(2) << setw(10) << z_worst[i];
+        if (!variants[i].windowed)
+        {
+            cout << setw(12) << "t -> inf" << setw(8) << "-" << endl;
+            continue;
+        }
+        cout << setw(9) << n_points - n_failed[i] << " / " << n_points << setw(8) << (pass ? "PASS" : "FAIL") << endl;
+    }
+    cout << endl << " " << (all_pass ? "all engines agree with the reference" : "some engines disagree with the reference") << endl;
+    return all_pass ? 0 : 1;
+}